@@ -0,0 +1,53 @@
+// object-oriented-chess-game/batch_analysis.hpp
+//
+// Header file for analysing a list of positions
+// on every core without any interaction
+//
+// Author: Jason Dominguez
+
+
+#ifndef BATCH_ANALYSIS_H
+#define BATCH_ANALYSIS_H
+
+
+#include <string>
+#include <iostream>
+#include <cstddef>
+#include "chess_engine.hpp"
+#include "engine_context.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    struct batch_analysis_options
+    {
+        int max_depth{8};
+        // Node and time limits for each position, zero meaning no limit
+        long long max_nodes{0};
+        int max_time_ms{0};
+        // Zero runs on the program's shared pool, with one thread per hardware core
+        int number_of_threads{0};
+        size_t transposition_table_entries{default_transposition_table_entries};
+    };
+
+    struct batch_analysis_summary
+    {
+        long long positions_analysed{};
+        long long invalid_positions{};
+        long long nodes_searched{};
+        double seconds{};
+    };
+
+    // Analyses one FEN per line of the input (blank lines are skipped) and writes one JSON object per
+    // position to the output, in the same order as the input, as soon as it and every position before it
+    // are done. Each object has the input line number and FEN, then either the best move, score, depth,
+    // nodes and time in milliseconds, or an error for a line that isn't a valid FEN, e.g.
+    // {"line":1,"fen":"...","best_move":"e2e4","score_cp":31,"depth":8,"nodes":40213,"time_ms":52.4}
+    // Mates are given as "score_mate" in moves, negative when the side to move is being mated and zero
+    // when it already is. Positions with no legal moves have a null best move
+    batch_analysis_summary analyse_positions(std::istream& fen_input, std::ostream& json_output,
+                                             const batch_analysis_options& options);
+    std::string escape_json_string(const std::string& text);
+}
+
+#endif
@@ -0,0 +1,91 @@
+// object-oriented-chess-game/batch_evaluation.hpp
+//
+// Header file for evaluating large batches of
+// positions with vector instructions
+//
+// Author: Jason Dominguez
+
+
+#ifndef BATCH_EVALUATION_H
+#define BATCH_EVALUATION_H
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "evaluation.hpp"
+
+
+// Forward declarations
+namespace brd {
+    class board;
+}
+
+
+// Class and function definitions
+namespace evl {
+    enum batch_kernel {scalar_batch_kernel, avx2_batch_kernel, avx512_batch_kernel};
+
+    // Positions are padded to a multiple of this, the most any kernel evaluates at once
+    const int batch_lane_count{16};
+
+    // Bitboards kept for each position to count mobility, bit i being board index i (a1 = 0)
+    enum batch_bitboard {occupied_squares,
+                         white_pieces, white_knights, white_diagonal_sliders, white_straight_sliders,
+                         black_pieces, black_knights, black_diagonal_sliders, black_straight_sliders,
+                         number_of_batch_bitboards};
+
+    batch_kernel get_batch_kernel();
+    std::string batch_kernel_to_string(batch_kernel kernel);
+
+
+    // Positions stored structure-of-arrays, square by square, so a kernel reads the same square of
+    // consecutive positions with one load. Piece codes are 0 for an empty square, 1-6 for white's
+    // pawn to king and 9-14 for black's
+    class position_batch
+    {
+    private:
+        size_t number_of_positions{};
+        size_t padded_size{};
+        // Code of square s in position p is at piece_codes[s*padded_size + p]
+        std::vector<std::uint8_t> piece_codes;
+        std::vector<std::uint64_t> bitboards[number_of_batch_bitboards];
+        // Pawn structure is scored when a position is added, it is rarely worth vectorising
+        std::vector<std::int32_t> pawn_scores[2];
+        pawn_hash_table pawn_table{1 << 12};
+
+        void grow(size_t new_padded_size);
+
+    public:
+        // Constructors
+        position_batch() {}
+        position_batch(size_t expected_positions) { reserve(expected_positions); }
+        // Destructor
+        ~position_batch(){}
+
+        // Member functions
+        void add(const brd::board& chess_board);
+        void reserve(size_t expected_positions);
+        void clear();
+        size_t size() const { return number_of_positions; }
+        size_t get_padded_size() const { return padded_size; }
+        const std::uint8_t* get_piece_codes(int square) const { return piece_codes.data() + square*padded_size; }
+        const std::uint64_t* get_bitboards(batch_bitboard bitboard) const { return bitboards[bitboard].data(); }
+        const std::int32_t* get_pawn_scores(game_stage stage) const { return pawn_scores[stage].data(); }
+    };
+
+
+    struct batch_evaluation
+    {
+        // Same as eng::evaluate with white to move: material, piece-square tables and pawn structure
+        std::vector<int> scores;
+        // Squares the knights, bishops, rooks and queens attack that aren't their own pieces, white's
+        // minus black's. Reported alongside the score, the hand written evaluation doesn't weight it
+        std::vector<int> mobility;
+    };
+
+    batch_evaluation evaluate_batch(const position_batch& batch);
+    batch_evaluation evaluate_batch(const position_batch& batch, batch_kernel kernel);
+}
+
+#endif
@@ -12,12 +12,11 @@
 #include <iostream>
 #include <vector>
 #include <memory>
-
-
-// Forward declarations
-namespace pcs {
-    class chess_piece;
-}
+#include <cstdint>
+#include <string>
+#include <utility>
+#include "chess_pieces.hpp"
+#include "neural_network.hpp"
 
 
 // Class and function definitions
@@ -28,6 +27,9 @@ namespace brd {
     enum move_type {standard, en_passant, castling};
 
     std::vector<std::unique_ptr<pcs::chess_piece>> initialize_board(std::vector<std::unique_ptr<pcs::chess_piece>> chess_board);
+    std::uint64_t pawn_zobrist_key(pcs::color pawn_color, int position);
+    // Pieces (in board index order) and side to move from a Forsyth-Edwards Notation string
+    std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> read_fen(std::string fen);
 
     class board
     {
@@ -37,6 +39,23 @@ namespace brd {
     private:
         std::vector<std::unique_ptr<pcs::chess_piece>> chess_board;
 
+        // Evaluation kept up to date as pieces are added to and removed from the board
+        int middlegame_score{};
+        int endgame_score{};
+        int game_phase{};
+        std::uint64_t pawn_hash{};
+        // Only built once a neural network is loaded and the board is evaluated with it
+        mutable nnue::accumulator piece_accumulator;
+
+        void add_piece_to_evaluation(int position);
+        void remove_piece_from_evaluation(int position);
+        void relocate_piece(int initial_position, int final_position);
+        void remove_piece(int position);
+        void initialize_evaluation();
+
+        bool find_attackers(int position, pcs::color attacking_color, 
+                            std::uint64_t ignored_squares, std::vector<int>* attackers) const;
+
     public:
         board();
         board(const board &board_to_copy);
@@ -48,6 +67,17 @@ namespace brd {
         std::unique_ptr<pcs::chess_piece> operator[](int idx) const;
         std::unique_ptr<pcs::chess_piece> & operator[](int idx);
         std::vector<std::unique_ptr<pcs::chess_piece>> get_board() const;
+        pcs::chess_piece* get_piece(int position) const { return chess_board[position].get(); }
+        bool is_square_attacked(int position, pcs::color attacking_color) const;
+        std::vector<int> get_attackers(int position, pcs::color attacking_color, std::uint64_t ignored_squares) const;
+        int find_king(pcs::color king_color) const;
+        void promote_pawn(int position, char promotion_symbol);
+        int get_evaluation() const;
+        int get_game_phase() const { return game_phase; }
+        int get_middlegame_score() const { return middlegame_score; }
+        int get_endgame_score() const { return endgame_score; }
+        std::uint64_t get_pawn_hash() const { return pawn_hash; }
+        nnue::accumulator& get_accumulator() const { return piece_accumulator; }
         void reset();
     };  
 }
@@ -0,0 +1,250 @@
+// object-oriented-chess-game/chess_engine.hpp
+//
+// Header file for chess engine search
+// and move ordering
+//
+// Author: Jason Dominguez
+
+
+#ifndef CHESS_ENGINE_H
+#define CHESS_ENGINE_H
+
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "evaluation.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    const int checkmate_score{100000};
+    const int infinite_score{1000000};
+    const int max_search_ply{64};
+    // Scores this close to checkmate_score are mates, which from the tablebases can be longer than the search
+    const int max_mate_ply{256};
+
+    struct move
+    {
+        int start_position{-1};
+        int end_position{-1};
+        char promotion_symbol{};
+
+        move() {}
+        move(int start, int end) : start_position{start}, end_position{end} {}
+        move(int start, int end, char promotion) : start_position{start}, end_position{end}, promotion_symbol{promotion} {}
+
+        bool is_valid() const { return start_position >= 0 && end_position >= 0; }
+        bool operator==(const move &other) const {
+            return start_position == other.start_position && end_position == other.end_position &&
+                   promotion_symbol == other.promotion_symbol;
+        }
+        bool operator!=(const move &other) const { return !(*this == other); }
+    };
+
+    struct analysed_line
+    {
+        int score{};
+        int depth{};
+        // Starts with the line's root move
+        std::vector<move> principal_variation;
+    };
+
+    int piece_type_index(char piece_symbol);
+    int piece_value(char piece_symbol);
+    std::uint64_t position_hash(const brd::board& chess_board, pcs::color side_to_move);
+    // Coordinate notation, e.g. e2e4 or e7e8Q
+    std::string move_to_string(const move& chosen_move);
+    // Pawns from the side to move's point of view, e.g. +0.35, or the moves to a forced mate, e.g. #3 or #-2
+    std::string score_to_string(int score);
+    brd::move_type get_move_type(const brd::board& chess_board, const move& chosen_move);
+    bool is_capture(const brd::board& chess_board, const move& chosen_move);
+    bool is_in_check(const brd::board& chess_board, pcs::color king_color);
+    void make_move(brd::board& chess_board, const move& chosen_move);
+    std::vector<move> generate_legal_moves(const brd::board& chess_board, pcs::color side_to_move);
+    std::vector<move> generate_legal_moves(const brd::board& chess_board, pcs::color side_to_move, bool captures_only);
+    int static_exchange_evaluation(const brd::board& chess_board, const move& capture);
+    bool has_non_pawn_material(const brd::board& chess_board, pcs::color piece_color);
+    int evaluate(const brd::board& chess_board, pcs::color side_to_move);
+    int evaluate(const brd::board& chess_board, pcs::color side_to_move, evl::pawn_hash_table& pawn_table);
+
+
+    // Selective search techniques, each can be switched off to compare against the full width search
+    struct search_options
+    {
+        bool use_null_move_pruning{true};
+        bool use_late_move_reductions{true};
+        bool use_futility_pruning{true};
+        // Neural network evaluation replaces the hand written evaluation once a network is loaded
+        bool use_neural_network{true};
+    };
+
+
+    // Node and time limits on a single search, zero meaning no limit. They only apply once the
+    // first iteration has completed, so a limited search always has a move to return
+    struct search_limits
+    {
+        long long max_nodes{0};
+        int max_time_ms{0};
+    };
+
+
+    enum bound_type {exact_bound, lower_bound, upper_bound};
+
+    struct tt_entry
+    {
+        std::uint64_t key{};
+        move best_move{};
+        int score{};
+        int depth{-1};
+        bound_type bound{exact_bound};
+    };
+
+
+    // Saved tables are this header followed by the entries exactly as they are held in memory.
+    // The hash scheme is a fingerprint of the Zobrist keys, entries saved with other keys are useless
+    const std::uint32_t transposition_table_file_version{1};
+
+    struct tt_file_header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t entry_size;
+        std::uint64_t hash_scheme;
+        std::uint64_t number_of_entries;
+    };
+
+    std::uint64_t hash_scheme_fingerprint();
+
+
+    class transposition_table
+    {
+    private:
+        // Entries point either into owned_entries or, after loading a saved table, into a private
+        // copy-on-write mapping of the file, so only the pages a search touches are read from disk
+        std::vector<tt_entry> owned_entries;
+        tt_entry* entries{nullptr};
+        size_t number_of_entries{};
+        void* mapping{nullptr};
+        size_t mapping_size{};
+
+        void unmap();
+
+    public:
+        // Constructors
+        transposition_table(size_t number_of_entries);
+        transposition_table(const transposition_table &table_to_copy) = delete;
+        transposition_table& operator=(const transposition_table &table_to_copy) = delete;
+        // Destructor
+        ~transposition_table() { unmap(); }
+
+        // Member functions
+        bool probe(std::uint64_t key, tt_entry& entry) const;
+        void store(const tt_entry& entry);
+        void clear();
+        void resize(size_t number_of_entries);
+        size_t get_number_of_entries() const { return number_of_entries; }
+        void save(std::string file_name) const;
+        void load(std::string file_name);
+        bool is_memory_mapped() const { return mapping != nullptr; }
+    };
+
+
+    class search
+    {
+    private:
+        // Tables below are kept from one search to the next, so a search object that lives
+        // across moves and games starts each search with what earlier ones learnt
+        transposition_table table;
+        evl::pawn_hash_table pawn_table;
+        move killer_moves[max_search_ply][2];
+        int history[2][64][64];
+        move root_best_move;
+        // Root moves skipped by the search, which is how the lines after the first are found
+        std::vector<move> excluded_root_moves;
+        long long nodes_searched{};
+        search_options options;
+        // Set from another thread to abandon the search, keeping the last completed iteration
+        std::atomic<bool> stop_requested{false};
+        search_limits limits;
+        bool limit_reached{false};
+        bool has_completed_iteration{false};
+        std::chrono::steady_clock::time_point search_start;
+        // Result of the last completed iteration, which can be read while the search is running
+        mutable std::mutex result_mutex;
+        std::pair<move, int> completed_result{};
+        int completed_depth{};
+
+        int negamax(const brd::board& chess_board, pcs::color side_to_move, int depth, int alpha, int beta, int ply,
+                    bool null_move_allowed);
+        int quiescence(const brd::board& chess_board, pcs::color side_to_move, int alpha, int beta, int ply);
+        int static_evaluation(const brd::board& chess_board, pcs::color side_to_move);
+        std::vector<int> score_moves(const brd::board& chess_board, pcs::color side_to_move,
+                                     const std::vector<move>& moves, const move& hash_move, int ply);
+        void update_quiet_move_tables(const move& cutoff_move, pcs::color side_to_move, int depth, int ply);
+        void start_new_search();
+        void check_limits();
+        bool is_stopped() const { return stop_requested || limit_reached; }
+
+    public:
+        // Constructors
+        search();
+        search(const search_options& search_settings);
+        // Destructor
+        ~search(){}
+
+        // Member functions
+        std::pair<move, int> find_best_move(const brd::board& chess_board, pcs::color side_to_move, int max_depth);
+        std::vector<analysed_line> find_best_lines(const brd::board& chess_board, pcs::color side_to_move, int max_depth,
+                                                   int number_of_lines);
+        // Score once the captures in the position have been played out, e.g. to find quiet positions
+        int quiet_evaluation(const brd::board& chess_board, pcs::color side_to_move);
+        std::vector<move> get_principal_variation(const brd::board& chess_board, pcs::color side_to_move,
+                                                  const move& first_move, int max_length) const;
+        long long get_nodes_searched() { return nodes_searched; }
+        int get_completed_depth() const;
+        std::pair<move, int> get_completed_result() const;
+        void stop() { stop_requested = true; }
+        // Stopped searches have to be reset before the search can be used again
+        void reset_stop() { stop_requested = false; }
+        void set_limits(const search_limits& new_limits) { limits = new_limits; }
+        void clear();
+        void resize_transposition_table(size_t number_of_entries);
+        size_t get_transposition_table_size() const { return table.get_number_of_entries(); }
+        void save_transposition_table(std::string file_name) const { table.save(file_name); }
+        void load_transposition_table(std::string file_name) { table.load(file_name); }
+        move get_hash_move(const brd::board& chess_board, pcs::color side_to_move) const;
+        double get_pawn_hash_hit_rate() { return pawn_table.get_hit_rate(); }
+    };
+
+
+    // Search left running on its own thread, e.g. to give hints, which can be asked
+    // for its best move so far at any time
+    class background_analysis
+    {
+    private:
+        brd::board analysis_board;
+        search analysis_search;
+        std::atomic<bool> is_finished{false};
+        std::thread analysis_thread;
+
+    public:
+        // Constructors
+        background_analysis(const brd::board& chess_board, pcs::color side_to_move, int max_depth);
+        // Destructor
+        ~background_analysis();
+
+        // Member functions
+        std::pair<move, int> get_best_move(int latency_ms);
+        int get_depth() const { return analysis_search.get_completed_depth(); }
+    };
+}
+
+#endif
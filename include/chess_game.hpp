@@ -10,7 +10,7 @@
 
 
 #include <string>
-#include <tuple>
+#include <atomic>
 #include "chess_board.hpp"
 
 
@@ -32,7 +32,6 @@ namespace cgm {
                       draw};
     
     std::vector<std::string> read_pgn(std::string file_name);
-    std::tuple<char, int, int, bool, char, brd::move_type> parse_pgn_move_notation(std::string loaded_move, pcs::color player_color);
 
     class chess_game
     {
@@ -42,11 +41,16 @@ namespace cgm {
         brd::board chess_board;
         game_status status;
         std::vector<std::string> moves_played;
+        // Promotion piece of the move just chosen, zero if the player is to be asked
+        char chosen_promotion_symbol{};
+        // Headless games, e.g. self-play between bots, print nothing and never wait for input
+        bool is_headless{false};
 
-        static int games_played;
-        static int player_one_wins;
-        static int player_two_wins;
-        static int draws;
+        // Games can be played on several threads at once
+        static std::atomic<int> games_played;
+        static std::atomic<int> player_one_wins;
+        static std::atomic<int> player_two_wins;
+        static std::atomic<int> draws;
 
     public:
         // Constructors
@@ -57,6 +61,12 @@ namespace cgm {
             players.push_back(current_player);
             players.push_back(std::move(player_two));
         }
+        chess_game(std::shared_ptr<plr::player> player_one, std::shared_ptr<plr::player> player_two, bool headless_game) :
+            current_player{player_one}, chess_board(), status{active}, is_headless{headless_game} {
+
+            players.push_back(std::move(player_one));
+            players.push_back(std::move(player_two));
+        }
         // Destructor
         ~chess_game(){}
 
@@ -65,6 +75,8 @@ namespace cgm {
         game_status get_game_status() { return status; }
         brd::board get_chess_board() { return chess_board; }
         bool has_ended() { return status == checkmate || status == draw; }
+        // Draws the engine spots but the game doesn't, e.g. stalemate, repetition or the fifty move rule
+        void declare_draw() { status = draw; }
         void get_next_player_ready();
         bool current_player_make_a_move(bool in_check);
         void promote_pawn_if_possible();
@@ -0,0 +1,60 @@
+// object-oriented-chess-game/engine_context.hpp
+//
+// Header file for the engine state a chess bot
+// keeps across moves and games
+//
+// Author: Jason Dominguez
+
+
+#ifndef ENGINE_CONTEXT_H
+#define ENGINE_CONTEXT_H
+
+
+#include <cstddef>
+#include <string>
+#include <memory>
+#include "chess_engine.hpp"
+#include "monte_carlo_search.hpp"
+#include "thread_pool.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    const size_t default_transposition_table_entries{1 << 16};
+
+    size_t transposition_table_entries_for_megabytes(size_t megabytes);
+
+
+    // Searches and the worker threads they run on, created once and reused for every
+    // move so the transposition table, history and evaluation caches carry over
+    class engine_context
+    {
+    private:
+        std::shared_ptr<thr::thread_pool> worker_pool;
+        search alpha_beta_search;
+        monte_carlo_search tree_search;
+
+    public:
+        // Constructors
+        engine_context();
+        // Zero threads shares the program's thread pool
+        engine_context(size_t transposition_table_entries, size_t number_of_threads);
+        engine_context(const engine_context &context_to_copy) = delete;
+        engine_context& operator=(const engine_context &context_to_copy) = delete;
+        // Destructor
+        ~engine_context(){}
+
+        // Member functions
+        search& get_search() { return alpha_beta_search; }
+        monte_carlo_search& get_tree_search() { return tree_search; }
+        thr::thread_pool& get_thread_pool() { return *worker_pool; }
+        void clear();
+        void resize_transposition_table(size_t number_of_entries);
+        size_t get_transposition_table_size() const { return alpha_beta_search.get_transposition_table_size(); }
+        // Saved tables let later sessions start their analysis warm
+        void save_transposition_table(std::string file_name) const;
+        void load_transposition_table(std::string file_name);
+    };
+}
+
+#endif
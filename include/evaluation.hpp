@@ -0,0 +1,126 @@
+// object-oriented-chess-game/evaluation.hpp
+//
+// Header file for material and piece-square
+// table evaluation
+//
+// Author: Jason Dominguez
+
+
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include "chess_pieces.hpp"
+
+
+// Forward declarations
+namespace brd {
+    class board;
+}
+
+
+// Class and function definitions
+namespace evl {
+    // Phase of the game is counted down from 24 (all minor and major pieces on the board)
+    // to 0 (only kings and pawns), with the two scores blended accordingly
+    const int max_game_phase{24};
+
+    enum game_stage {middlegame, endgame};
+
+
+    // Everything the hand written evaluation is built from, split into middlegame and endgame
+    // values. Pieces are numbered pawn, knight, bishop, rook, queen, king and piece-square tables
+    // are laid out as seen from above the board from white's side (first row is the 8th rank)
+    struct evaluation_weights
+    {
+        int material_values[2][6];
+        int piece_square_tables[6][2][64];
+        int doubled_pawn_penalty[2];
+        int isolated_pawn_penalty[2];
+        int backward_pawn_penalty[2];
+        int passed_pawn_bonus[2][8];
+    };
+
+    const int number_of_parameters{2*6 + 6*2*64 + 3*2 + 2*8};
+
+    const evaluation_weights& get_default_weights();
+    const evaluation_weights& get_weights();
+    // Boards keep running piece-square totals, so new weights only apply to boards created afterwards
+    void set_weights(const evaluation_weights& new_weights);
+    void save_weights(std::string file_name, const evaluation_weights& weights);
+    void load_weights(std::string file_name);
+    std::vector<int> weights_to_parameters(const evaluation_weights& weights);
+    evaluation_weights parameters_to_weights(const std::vector<int>& parameters);
+
+    int piece_type(char piece_symbol);
+    int piece_square_value(char piece_symbol, pcs::color piece_color, int position, game_stage stage);
+    int piece_phase(char piece_symbol);
+    int tapered_score(int middlegame_score, int endgame_score, int game_phase);
+
+
+    // Doubled, isolated, backward and passed pawn terms from white's point of view
+    struct pawn_structure_score
+    {
+        int middlegame{};
+        int endgame{};
+    };
+
+    // Number of pawns given each pawn structure term, white's minus black's
+    struct pawn_structure_terms
+    {
+        int doubled_pawns{};
+        int isolated_pawns{};
+        int backward_pawns{};
+        // Passed pawns by rank from the pawn's own side
+        int passed_pawns[8]{};
+    };
+
+    pawn_structure_terms count_pawn_structure_terms(const brd::board& chess_board);
+    pawn_structure_score evaluate_pawn_structure(const brd::board& chess_board);
+
+
+    // The evaluation is linear in its weights: it is the sum of each parameter (numbered as in
+    // weights_to_parameters) times how often it applies, white's minus black's, for the middlegame
+    // and the endgame, then blended by the game phase. Used to tune the weights
+    struct evaluation_features
+    {
+        std::vector<std::pair<int, int>> terms[2];
+        int game_phase{};
+    };
+
+    evaluation_features get_evaluation_features(const brd::board& chess_board);
+
+
+    // Pawn structure changes far less often than the rest of the position, so its
+    // score is cached under the board's pawn-only hash
+    class pawn_hash_table
+    {
+    private:
+        struct pawn_entry
+        {
+            std::uint64_t key{};
+            pawn_structure_score score{};
+            bool is_used{false};
+        };
+        std::vector<pawn_entry> entries;
+        long long probes{};
+        long long hits{};
+
+    public:
+        // Constructors
+        pawn_hash_table(size_t number_of_entries) : entries(number_of_entries) {}
+        // Destructor
+        ~pawn_hash_table(){}
+
+        // Member functions
+        pawn_structure_score get_score(const brd::board& chess_board);
+        void clear();
+        double get_hit_rate() const { return probes > 0 ? static_cast<double>(hits)/probes : 0.0; }
+    };
+}
+
+#endif
@@ -0,0 +1,102 @@
+// object-oriented-chess-game/game_archive.hpp
+//
+// Header file for the compact binary file of games
+// kept alongside portable game notation
+//
+// Author: Jason Dominguez
+
+
+#ifndef GAME_ARCHIVE_H
+#define GAME_ARCHIVE_H
+
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ostream>
+#include <cstdint>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "pgn_reader.hpp"
+#include "pgn_import.hpp"
+
+
+// Class and function definitions
+namespace cgm {
+    // Files are a 16 byte header ("OOCGGAME", uint32 version, uint32 flags, zero) followed by one little
+    // endian record per game:
+    //   uint32 size of the rest of the record, result (0 *, 1 1-0, 2 0-1, 3 1/2-1/2), number of tags,
+    //   the tags, uint16 number of moves and a uint16 per move
+    // Each tag is a code for the common tag names (see game_archive.cpp) or 0 followed by a byte long
+    // name, then a uint16 long value. Moves are from square | to square << 6 | promotion << 12 (0 none,
+    // 1 queen, 2 rook, 3 bishop, 4 knight), so loading checks and plays them without parsing notation or
+    // generating moves
+    const std::uint32_t game_archive_version{1};
+    const std::string game_archive_extension{".ccg"};
+
+    std::uint16_t encode_move(const eng::move& chosen_move);
+    eng::move decode_move(std::uint16_t move_code);
+    // Plays the move if it is legal for the side to move, and otherwise throws invalid_argument
+    void play_archived_move(brd::board& chess_board, pcs::color side_to_move, const eng::move& archived_move);
+    // Moves from the game's starting position (the FEN tag's, if it has one) as standard algebraic notation,
+    // throwing invalid_argument at the first move that isn't legal
+    std::vector<std::string> moves_to_san(const pgn_game& game, const std::vector<eng::move>& moves);
+    // Tags, movetext wrapped to 80 columns and the result, followed by a blank line
+    void write_pgn_game(std::ostream& pgn_output, const pgn_game& game);
+    // Games that can't be replayed are left out, and counted as invalid in the summary
+    pgn_import_summary convert_pgn_to_archive(std::string pgn_file_name, std::string archive_file_name,
+                                              const pgn_import_options& options);
+    // Returns the number of games written
+    long long convert_archive_to_pgn(std::string archive_file_name, std::string pgn_file_name);
+
+
+    class game_archive_writer
+    {
+    private:
+        std::ofstream archive_file;
+        std::vector<unsigned char> record;
+        long long games_written{};
+
+    public:
+        // Constructors
+        game_archive_writer(std::string file_name);
+        game_archive_writer(const game_archive_writer &writer_to_copy) = delete;
+        game_archive_writer& operator=(const game_archive_writer &writer_to_copy) = delete;
+        // Destructor
+        ~game_archive_writer(){}
+
+        // Member functions
+        // The game's tags and result are stored with the moves, its moves as notation are not
+        void write(const pgn_game& game, const std::vector<eng::move>& moves);
+        void flush();
+        void close();
+        long long get_games_written() const { return games_written; }
+    };
+
+
+    class game_archive_reader
+    {
+    private:
+        std::ifstream archive_file;
+        std::vector<unsigned char> record;
+        std::uint64_t bytes_left{};
+        long long games_read{};
+
+    public:
+        // Constructors
+        game_archive_reader(std::string file_name);
+        game_archive_reader(const game_archive_reader &reader_to_copy) = delete;
+        game_archive_reader& operator=(const game_archive_reader &reader_to_copy) = delete;
+        // Destructor
+        ~game_archive_reader(){}
+
+        // Member functions
+        // Replaces the game's tags and result and the moves with the next game's, leaving the game's
+        // notation empty, and returns false once there are none left
+        bool read_game(pgn_game& game, std::vector<eng::move>& moves);
+        long long get_games_read() const { return games_read; }
+    };
+}
+
+#endif
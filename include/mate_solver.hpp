@@ -0,0 +1,82 @@
+// object-oriented-chess-game/mate_solver.hpp
+//
+// Header file for the mate-in-N solver using
+// depth-first proof-number search
+//
+// Author: Jason Dominguez
+
+
+#ifndef MATE_SOLVER_H
+#define MATE_SOLVER_H
+
+
+#include <vector>
+#include <cstdint>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    struct mate_solver_options
+    {
+        // Longest mate looked for, in moves of the attacking side
+        int max_moves{5};
+        long long max_nodes{1000000};
+        size_t hash_entries{1 << 20};
+    };
+
+    struct mate_result
+    {
+        bool found{false};
+        // No mate was found, but the node limit was reached before every line was checked
+        bool node_limit_reached{false};
+        int moves_to_mate{};
+        // Attacker's and defender's moves in turn, ending in checkmate
+        std::vector<move> mating_line;
+        long long nodes_searched{};
+    };
+
+
+    class mate_solver
+    {
+    private:
+        // Proof number: leaves still to be proven for a mate, disproof number: leaves still to be
+        // shown to escape it. Each node stores them as phi and delta from its own side's point of view,
+        // so at the attacker's nodes phi is the proof number and at the defender's the disproof number
+        struct pn_entry
+        {
+            std::uint64_t key{};
+            std::uint32_t phi{};
+            std::uint32_t delta{};
+            bool is_used{false};
+        };
+
+        mate_solver_options options;
+        std::vector<pn_entry> table;
+        long long nodes_searched{};
+        long long node_limit{};
+
+        std::uint64_t node_key(const brd::board& chess_board, pcs::color side_to_move, bool is_attacker, int moves_left) const;
+        bool lookup(std::uint64_t key, std::uint32_t& phi, std::uint32_t& delta) const;
+        void store(std::uint64_t key, std::uint32_t phi, std::uint32_t delta);
+        void multiple_iterative_deepening(const brd::board& chess_board, pcs::color side_to_move, bool is_attacker,
+                                          int moves_left, std::uint32_t phi_threshold, std::uint32_t delta_threshold);
+        bool attacker_wins(const brd::board& chess_board, pcs::color side_to_move, bool is_attacker, int moves_left);
+        void build_mating_line(const brd::board& chess_board, pcs::color attacker, int moves_to_mate, std::vector<move>& line);
+
+    public:
+        // Constructors
+        mate_solver();
+        mate_solver(const mate_solver_options& solver_settings);
+        // Destructor
+        ~mate_solver(){}
+
+        // Member functions
+        mate_result solve(const brd::board& chess_board, pcs::color attacker);
+        void clear();
+    };
+}
+
+#endif
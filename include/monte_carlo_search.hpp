@@ -0,0 +1,94 @@
+// object-oriented-chess-game/monte_carlo_search.hpp
+//
+// Header file for Monte Carlo tree search
+// engine mode
+//
+// Author: Jason Dominguez
+
+
+#ifndef MONTE_CARLO_SEARCH_H
+#define MONTE_CARLO_SEARCH_H
+
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "evaluation.hpp"
+#include "thread_pool.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    move choose_playout_move(const brd::board& chess_board, const std::vector<move>& moves, std::mt19937& random_engine);
+
+
+    struct monte_carlo_options
+    {
+        // Zero uses one worker per thread of the pool
+        int number_of_threads{0};
+        int time_limit_ms{2000};
+        long long max_playouts{20000};
+        // Playouts stop after this many moves and the position is scored with the evaluation
+        int max_playout_length{24};
+        double exploration_constant{1.4};
+        // Visits added to nodes currently being played out by another thread
+        int virtual_loss{3};
+    };
+
+
+    class monte_carlo_search
+    {
+    private:
+        struct tree_node
+        {
+            move move_played{};
+            pcs::color side_to_move{};
+            tree_node* parent{nullptr};
+            std::vector<std::unique_ptr<tree_node>> children;
+            std::vector<move> untried_moves;
+            bool moves_generated{false};
+            long long visits{};
+            int virtual_losses{};
+            // Sum of results from the point of view of the player who made move_played
+            double total_value{};
+        };
+
+        monte_carlo_options options;
+        // Workers run on this pool when one is given, otherwise on the program's shared pool
+        thr::thread_pool* worker_pool{nullptr};
+        std::unique_ptr<tree_node> root;
+        // Position being searched, only valid during find_best_move
+        const brd::board* root_board{nullptr};
+        // Selection, expansion and backpropagation are short, playouts run without the lock
+        std::mutex tree_mutex;
+        std::atomic<long long> playouts_completed{};
+        std::chrono::steady_clock::time_point start_time;
+
+        void run_worker(unsigned int seed);
+        bool budget_exhausted();
+        tree_node* select_child(tree_node* node);
+        double playout(brd::board& chess_board, pcs::color side_to_move, std::mt19937& random_engine,
+                       evl::pawn_hash_table& pawn_table);
+
+    public:
+        // Constructors
+        monte_carlo_search() {}
+        monte_carlo_search(const monte_carlo_options& search_settings) : options{search_settings} {}
+        monte_carlo_search(const monte_carlo_options& search_settings, thr::thread_pool& pool) :
+            options{search_settings}, worker_pool{&pool} {}
+        // Destructor
+        ~monte_carlo_search(){}
+
+        // Member functions
+        move find_best_move(const brd::board& chess_board, pcs::color side_to_move);
+        long long get_playouts_completed() { return playouts_completed; }
+    };
+}
+
+#endif
@@ -0,0 +1,66 @@
+// object-oriented-chess-game/neural_network.hpp
+//
+// Header file for efficiently updatable
+// neural network (NNUE) evaluation
+//
+// Author: Jason Dominguez
+
+
+#ifndef NEURAL_NETWORK_H
+#define NEURAL_NETWORK_H
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "chess_pieces.hpp"
+
+
+// Forward declarations
+namespace brd {
+    class board;
+}
+
+
+// Class and function definitions
+namespace nnue {
+    // Network layout: 768 piece-square inputs (own/opposition pieces x 6 piece types x 64 squares,
+    // seen from each side) -> hidden layer of int16 accumulators for each side -> one output.
+    //
+    // Network file (little endian):
+    //   "OOCGNNUE"                      8 byte magic
+    //   uint32 version, uint32 hidden size (a multiple of 16)
+    //   int16  feature weights [768][hidden size]
+    //   int16  feature biases [hidden size]
+    //   int8   output weights [2*hidden size] (side to move first)
+    //   int32  output bias
+    const int number_of_features{768};
+    const std::uint32_t network_file_version{1};
+    // Hidden activations are clipped to [0, activation_clamp] and the output is
+    // scaled by output_scale/(activation_clamp*output_weight_scale) to give centipawns
+    const int activation_clamp{127};
+    const int output_weight_scale{64};
+    const int output_scale{400};
+
+    enum simd_level {scalar_instructions, sse2_instructions, avx2_instructions};
+
+    // First layer outputs for white's and black's point of view, kept up to date
+    // by the board as pieces are added and removed
+    struct accumulator
+    {
+        std::vector<std::int16_t> values[2];
+        int network_version{-1};
+    };
+
+    simd_level get_simd_level();
+    std::string simd_level_to_string(simd_level level);
+    void load_network(std::string file_name);
+    bool is_network_loaded();
+    int get_network_version();
+    int feature_index(char piece_symbol, pcs::color piece_color, int position, pcs::color perspective);
+    void refresh_accumulator(accumulator& piece_accumulator, const brd::board& chess_board);
+    void update_accumulator(accumulator& piece_accumulator, char piece_symbol, pcs::color piece_color, int position, bool add_piece);
+    int evaluate(const brd::board& chess_board, pcs::color side_to_move);
+}
+
+#endif
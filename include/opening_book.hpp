@@ -0,0 +1,68 @@
+// object-oriented-chess-game/opening_book.hpp
+//
+// Header file for Polyglot opening book
+// lookup
+//
+// Author: Jason Dominguez
+
+
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+
+
+// Class and function definitions
+namespace book {
+    // Polyglot .bin books are a list of 16 byte big endian entries sorted by key:
+    //   uint64 position key, uint16 move, uint16 weight, uint32 learn data
+    const int entry_size{16};
+    // Key layout: 12 pieces x 64 squares, 4 castling rights, 8 en passant files, side to move
+    const int number_of_random_keys{781};
+
+    struct book_move
+    {
+        eng::move chosen_move{};
+        int weight{};
+    };
+
+    std::uint64_t polyglot_key(const brd::board& chess_board, pcs::color side_to_move);
+    eng::move decode_polyglot_move(const brd::board& chess_board, std::uint16_t encoded_move);
+
+
+    class opening_book
+    {
+    private:
+        // Book file is memory-mapped read only, so only the pages touched by lookups are ever loaded
+        const unsigned char* entries{nullptr};
+        size_t number_of_entries{};
+
+        std::uint64_t read_key(size_t entry_index) const;
+
+    public:
+        // Constructors
+        opening_book() {}
+        opening_book(std::string file_name) { open(file_name); }
+        opening_book(const opening_book &book_to_copy) = delete;
+        opening_book& operator=(const opening_book &book_to_copy) = delete;
+        // Destructor
+        ~opening_book() { close(); }
+
+        // Member functions
+        void open(std::string file_name);
+        void close();
+        bool is_open() const { return entries != nullptr; }
+        size_t get_number_of_entries() const { return number_of_entries; }
+        std::vector<book_move> get_book_moves(const brd::board& chess_board, pcs::color side_to_move) const;
+        eng::move choose_book_move(const brd::board& chess_board, pcs::color side_to_move, std::mt19937& random_engine) const;
+    };
+}
+
+#endif
@@ -0,0 +1,63 @@
+// object-oriented-chess-game/pgn_import.hpp
+//
+// Header file for importing large PGN databases
+// on every core
+//
+// Author: Jason Dominguez
+
+
+#ifndef PGN_IMPORT_H
+#define PGN_IMPORT_H
+
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include "chess_engine.hpp"
+#include "pgn_reader.hpp"
+
+
+// Class and function definitions
+namespace cgm {
+    struct pgn_import_options
+    {
+        // Zero runs on the program's shared pool, with one thread per hardware core
+        int number_of_threads{0};
+        // Files are split into pieces of about this many bytes, at the start of a game, for the threads to take
+        size_t chunk_size{1 << 20};
+        // Without replaying, games are only split into tags, moves and result
+        bool replay_moves{true};
+    };
+
+    struct imported_game
+    {
+        // Position in the file, counting from one
+        long long game_number{};
+        pgn_game game;
+        // Moves as checked by replaying them, up to the first one that couldn't be
+        std::vector<eng::move> replayed_moves;
+        bool is_valid{false};
+        std::string error;
+    };
+
+    struct pgn_import_summary
+    {
+        long long games_imported{};
+        long long invalid_games{};
+        long long moves_replayed{};
+        size_t bytes_read{};
+        double seconds{};
+    };
+
+    // Replays the game's moves from its starting position (the FEN tag's, if it has one) through the
+    // legal move check, recording them or the reason the game is invalid
+    void replay_game(imported_game& game);
+
+    // Memory-maps the file, splits it where games start and imports the pieces on the thread pool.
+    // Games are passed to the handler one at a time in the order they are in the file
+    pgn_import_summary import_pgn_database(std::string file_name, const pgn_import_options& options,
+                                           const std::function<void(const imported_game&)>& game_handler);
+}
+
+#endif
@@ -0,0 +1,92 @@
+// object-oriented-chess-game/pgn_reader.hpp
+//
+// Header file for reading games one at a time
+// from portable game notation databases
+//
+// Author: Jason Dominguez
+
+
+#ifndef PGN_READER_H
+#define PGN_READER_H
+
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <istream>
+#include <fstream>
+#include <memory>
+#include <streambuf>
+#include <cstddef>
+
+
+// Class and function definitions
+namespace cgm {
+    struct pgn_game
+    {
+        // Tag pairs in the order they appear, e.g. ("White", "Carlsen, Magnus")
+        std::vector<std::pair<std::string, std::string>> tags;
+        // Main line moves exactly as written, less move numbers and annotations
+        std::vector<std::string> moves;
+        // 1-0, 0-1, 1/2-1/2 or * (unknown or unfinished)
+        std::string result{"*"};
+
+        // Empty if the game has no such tag
+        std::string get_tag(const std::string& tag_name) const;
+        void clear();
+    };
+
+
+    // Reads a stream of games written in portable game notation, one game at a time, so a database
+    // of any size is read with only one game in memory. Comments, variations, numeric annotation glyphs,
+    // move suffixes like !? and escaped lines are skipped, and moves can be laid out in any way
+    class pgn_reader
+    {
+    private:
+        // Text already in memory, e.g. a memory-mapped file, is read where it is
+        struct memory_buffer : public std::streambuf
+        {
+            memory_buffer(const char* text, size_t length) {
+                char* begin{const_cast<char*>(text)};
+                setg(begin, begin, begin + length);
+            }
+        };
+
+        std::unique_ptr<std::ifstream> pgn_file;
+        std::unique_ptr<memory_buffer> text_buffer;
+        std::streambuf* input{nullptr};
+        long long games_read{};
+        long long line_number{1};
+        size_t characters_read{};
+        bool is_at_line_start{true};
+
+        int next_character();
+        int peek_character();
+        std::string read_token(int first_character);
+        void read_tag(pgn_game& game);
+        void skip_comment();
+        void skip_rest_of_line();
+
+    public:
+        // Constructors
+        pgn_reader(std::string file_name);
+        pgn_reader(std::istream& pgn_input);
+        // The text must outlive the reader
+        pgn_reader(const char* text, size_t length);
+        // Text that starts partway through a file, with lines counted from the line it starts on
+        pgn_reader(const char* text, size_t length, long long first_line_number);
+        pgn_reader(const pgn_reader &reader_to_copy) = delete;
+        pgn_reader& operator=(const pgn_reader &reader_to_copy) = delete;
+        // Destructor
+        ~pgn_reader(){}
+
+        // Member functions
+        // Replaces the game with the next one in the stream, returning false once there are none left
+        bool read_game(pgn_game& game);
+        long long get_games_read() const { return games_read; }
+        long long get_line_number() const { return line_number; }
+        size_t get_characters_read() const { return characters_read; }
+    };
+}
+
+#endif
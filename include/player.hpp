@@ -11,12 +11,28 @@
 
 #include <string>
 #include <utility>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <random>
+#include <cstdint>
 #include "chess_pieces.hpp"
 #include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "engine_context.hpp"
+#include "thread_pool.hpp"
+
+
+// Forward declarations
+namespace book {
+    class opening_book;
+}
 
 
 // Class and function definitions
 namespace plr {
+    enum engine_mode {alpha_beta_search, monte_carlo_tree_search};
+
 
     class player
     {
@@ -25,6 +41,11 @@ namespace plr {
         pcs::color piece_color{};
         bool is_human{};
 
+        // Legal moves of the player's pieces with the given symbol (or all pieces for '\0'), in board order.
+        // Pieces are checked on the pool when one is given and there are enough moves to share out
+        std::vector<std::pair<int, std::vector<int>>> filter_possible_moves(char chess_piece, const brd::board& chess_board,
+                                                                            thr::thread_pool* worker_pool);
+
     public:
         // Constructors
         player() {}
@@ -41,8 +62,11 @@ namespace plr {
         virtual ~player(){}
 
         // Member functions
-        virtual std::pair<int, int> choose_move(const brd::board& chess_board)=0;
+        // Pawns moved to the last rank promote to the move's promotion piece, or ask when there is none
+        virtual eng::move choose_move(const brd::board& chess_board)=0;
         std::vector<std::pair<int, std::vector<int>>> get_player_possible_moves(const brd::board& chess_board);
+        std::vector<std::pair<int, std::vector<int>>> get_player_possible_moves(const brd::board& chess_board,
+                                                                                thr::thread_pool& worker_pool);
         std::vector<std::pair<int, std::vector<int>>> get_player_piece_possible_moves(char chess_piece, 
                                                                                       const brd::board& original_chess_board);
         std::pair<int, std::vector<int>> get_piece_valid_moves(int start_position_index, 
@@ -59,6 +83,12 @@ namespace plr {
 
     class human_player : public player
     {
+    private:
+        // Longest a hint may take, however far the background analysis has got
+        int hint_latency_ms{500};
+
+        void give_hint(eng::background_analysis& analysis);
+
     public:
         // Constructors
         human_player() { is_human = true; }
@@ -68,20 +98,58 @@ namespace plr {
         virtual ~human_player(){}
 
         // Member functions
-        std::pair<int, int> choose_move(const brd::board& chess_board);
+        eng::move choose_move(const brd::board& chess_board);
+        void set_hint_latency(int latency_ms) { hint_latency_ms = latency_ms; }
     };
 
 
     class chess_bot : public player
     {
+    private:
+        int search_depth{4};
+        engine_mode mode{alpha_beta_search};
+        std::shared_ptr<const book::opening_book> opening_book;
+        // Kept for the bot's lifetime, so every move and game reuses what earlier searches learnt
+        std::shared_ptr<eng::engine_context> engine{std::make_shared<eng::engine_context>()};
+        // Pondering: searching the position after the expected reply during the opposition's turn
+        eng::move predicted_reply{};
+        std::thread ponder_thread;
+        std::uint64_t ponder_position_hash{};
+        std::pair<eng::move, int> ponder_result{};
+        // Quiet bots print nothing, e.g. in self-play
+        bool is_quiet{false};
+        // First few moves can be chosen at random, so games between bots start from varied positions
+        int random_opening_moves{};
+        int moves_chosen{};
+        std::mt19937 random_engine{};
+        // Last move chosen and its search score for the bot, which is only known if it came from the search
+        eng::move last_move{};
+        int last_score{};
+        bool is_last_move_searched{false};
+
     public:
         // Constructors
         chess_bot(pcs::color player_color) : player("ChessBot", player_color, false) {} 
+        chess_bot(pcs::color player_color, int depth) : player("ChessBot", player_color, false), search_depth{depth} {} 
+        chess_bot(pcs::color player_color, engine_mode bot_mode) : player("ChessBot", player_color, false), mode{bot_mode} {} 
         // Destructor
-        virtual ~chess_bot(){}
+        virtual ~chess_bot(){ stop_pondering(); }
 
         // Member functions
-        std::pair<int, int> choose_move(const brd::board& chess_board);
+        eng::move choose_move(const brd::board& chess_board);
+        void set_opening_book(std::shared_ptr<const book::opening_book> book_to_use) { opening_book = book_to_use; }
+        void set_engine_context(std::shared_ptr<eng::engine_context> context_to_use);
+        std::shared_ptr<eng::engine_context> get_engine_context() { return engine; }
+        void clear_engine_context();
+        void resize_transposition_table(size_t number_of_entries);
+        std::vector<eng::analysed_line> get_best_lines(const brd::board& chess_board, pcs::color side_to_move, int number_of_lines);
+        void set_quiet(bool quiet) { is_quiet = quiet; }
+        void set_random_opening(int number_of_moves, unsigned int seed);
+        eng::move get_last_move() const { return last_move; }
+        int get_last_score() const { return last_score; }
+        bool get_is_last_move_searched() const { return is_last_move_searched; }
+        void start_pondering(const brd::board& chess_board);
+        void stop_pondering();
     };
 }
 
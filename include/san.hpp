@@ -0,0 +1,49 @@
+// object-oriented-chess-game/san.hpp
+//
+// Header file for reading and writing moves in
+// standard algebraic notation
+//
+// Author: Jason Dominguez
+
+
+#ifndef SAN_H
+#define SAN_H
+
+
+#include <string>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+
+
+// Class and function definitions
+namespace cgm {
+    // What a move in standard algebraic notation says about the move, e.g. Nbd2 is a knight
+    // from the b file to d2. Unknown parts of the starting square are -1
+    struct san_move
+    {
+        char piece_symbol{'p'};
+        int start_file{-1};
+        int start_rank{-1};
+        int end_position{-1};
+        // Zero unless a pawn promotes
+        char promotion_symbol{};
+        bool is_castling{false};
+    };
+
+    // Accepts captures with x or :, check and mate signs, suffixes like !?, promotions written =Q or Q,
+    // castling with O or 0, full starting squares (e2e4 or e2-e4) and this program's e.p. suffix
+    san_move parse_san(std::string notation, pcs::color side_to_move);
+    // The legal move the notation stands for, throwing if there is none or more than one. The pieces that
+    // could have made it are found from the end square, and only moves that might leave the king in
+    // check are played out on a copy of the board
+    eng::move resolve_san(const brd::board& chess_board, pcs::color side_to_move, const std::string& notation);
+    // Whether the piece on the start square belongs to the side to move and can make the move by the rules
+    // of how it moves (castling included), leaving only whether the move exposes the king to be checked
+    bool is_pseudo_legal(const brd::board& chess_board, pcs::color side_to_move, const eng::move& chosen_move);
+    // The move as standard algebraic notation, e.g. Nbd2, exd6, e8=Q+ or O-O-O#, disambiguated only
+    // against other pieces that could legally make the same move
+    std::string move_to_san(const brd::board& chess_board, pcs::color side_to_move, const eng::move& chosen_move);
+}
+
+#endif
@@ -0,0 +1,60 @@
+// object-oriented-chess-game/self_play.hpp
+//
+// Header file for generating training data from
+// games the chess bot plays against itself
+//
+// Author: Jason Dominguez
+
+
+#ifndef SELF_PLAY_H
+#define SELF_PLAY_H
+
+
+#include <string>
+#include <memory>
+#include <cstddef>
+#include "engine_context.hpp"
+
+
+// Forward declarations
+namespace book {
+    class opening_book;
+}
+
+
+// Class and function definitions
+namespace trn {
+    struct self_play_options
+    {
+        int number_of_games{1000};
+        int search_depth{4};
+        // Zero runs on the program's shared pool, with one thread per hardware core
+        int number_of_threads{0};
+        // Moves each bot plays at random before it starts searching, so no two games are alike
+        int random_opening_moves{4};
+        // Games still going after this many moves each are counted as draws
+        int max_moves{200};
+        // Transposition table of each thread's engine, which is kept from one game to the next
+        size_t transposition_table_entries{eng::default_transposition_table_entries};
+        // Zero picks a random seed
+        unsigned int seed{};
+        // Book moves are played after the random moves while the game is still in the book
+        std::shared_ptr<const book::opening_book> opening_book;
+    };
+
+    struct self_play_summary
+    {
+        long long games_played{};
+        long long positions_written{};
+        long long white_wins{};
+        long long black_wins{};
+        long long draws{};
+        double seconds{};
+    };
+
+    // Plays games between two bots on every thread and appends each searched position, with the bot's
+    // score and the game's result, to a training data file once its game is over
+    self_play_summary generate_self_play_data(std::string file_name, const self_play_options& options);
+}
+
+#endif
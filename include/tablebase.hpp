@@ -0,0 +1,49 @@
+// object-oriented-chess-game/tablebase.hpp
+//
+// Header file for endgame tablebase generation
+// and probing
+//
+// Author: Jason Dominguez
+
+
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+
+#include <string>
+#include <cstdint>
+#include "chess_pieces.hpp"
+
+
+// Forward declarations
+namespace brd {
+    class board;
+}
+
+
+// Class and function definitions
+namespace egtb {
+    // Tables cover a lone king against king and queen, rook, pawn or bishop and knight.
+    // Each entry is one byte: 0 for a draw, 255 for an unused index and otherwise
+    // the number of plies to mate plus one
+    const std::uint8_t draw_value{0};
+    const std::uint8_t unused_value{255};
+    const std::uint32_t tablebase_file_version{1};
+    const int max_tablebase_pieces{4};
+
+    struct probe_result
+    {
+        bool found{false};
+        bool is_draw{false};
+        bool side_to_move_wins{false};
+        int plies_to_mate{};
+    };
+
+    void generate_tablebases();
+    void generate_tablebases(std::string directory);
+    bool are_tablebases_loaded();
+    int get_number_of_pieces(const brd::board& chess_board);
+    probe_result probe(const brd::board& chess_board, pcs::color side_to_move);
+}
+
+#endif
@@ -0,0 +1,93 @@
+// object-oriented-chess-game/thread_pool.hpp
+//
+// Header file for a work-stealing pool of worker
+// threads shared by the engine and batch jobs
+//
+// Author: Jason Dominguez
+
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+
+// Class and function definitions
+namespace thr {
+    struct thread_pool_options
+    {
+        // Zero uses one thread per hardware core
+        size_t number_of_threads{0};
+        // Pins worker i to core first_core + i (wrapping round), so each worker keeps its caches warm.
+        // Only supported on Linux, elsewhere the workers are left to the scheduler
+        bool pin_to_cores{false};
+        size_t first_core{0};
+    };
+
+
+    class thread_pool
+    {
+    private:
+        // Workers take their own tasks from the back of their deque, newest first, and once it is
+        // empty steal the oldest task from the front of another worker's deque
+        struct worker_queue
+        {
+            std::deque<std::function<void()>> tasks;
+            std::mutex queue_mutex;
+        };
+
+        std::vector<std::unique_ptr<worker_queue>> queues;
+        std::vector<std::thread> workers;
+        // Idle workers sleep until a task is submitted
+        std::mutex sleep_mutex;
+        std::condition_variable task_available;
+        std::atomic<size_t> queued_tasks{0};
+        std::atomic<size_t> next_queue{0};
+        std::atomic<long long> tasks_stolen{0};
+        bool is_stopping{false};
+
+        void start_workers(const thread_pool_options& pool_settings);
+        void run_worker(size_t worker_index);
+        bool run_queued_task(size_t worker_index);
+        void push_task(std::function<void()> task);
+
+    public:
+        // Constructors
+        thread_pool(size_t number_of_threads);
+        thread_pool(const thread_pool_options& pool_settings);
+        thread_pool(const thread_pool &pool_to_copy) = delete;
+        thread_pool& operator=(const thread_pool &pool_to_copy) = delete;
+        // Destructor
+        ~thread_pool();
+
+        // Member functions
+        // Tasks submitted from one of the pool's own workers go on that worker's deque
+        std::future<void> submit(std::function<void()> task);
+        // Rethrows the task's exception. A worker waiting on a task runs other queued tasks meanwhile,
+        // so tasks that wait for tasks they submitted can't leave the pool stuck
+        void wait(std::future<void>& result);
+        // Runs work on ranges of up to chunk_size items, which the workers take as they become free
+        void parallel_for(size_t number_of_items, size_t chunk_size, const std::function<void(size_t, size_t)>& work);
+        size_t get_number_of_threads() const { return workers.size(); }
+        long long get_tasks_stolen() const { return tasks_stolen; }
+    };
+
+
+    // One pool for the whole program, so searches, tablebase generation and batch jobs running at the
+    // same time share the cores rather than each starting a thread per core
+    std::shared_ptr<thread_pool> get_shared_thread_pool();
+    // Pools with zero threads are the shared pool, any other number gets a pool of its own
+    std::shared_ptr<thread_pool> make_thread_pool(size_t number_of_threads);
+}
+
+#endif
@@ -0,0 +1,73 @@
+// object-oriented-chess-game/training_data.hpp
+//
+// Header file for the compact binary file of labelled
+// positions used to tune and train the evaluation
+//
+// Author: Jason Dominguez
+
+
+#ifndef TRAINING_DATA_H
+#define TRAINING_DATA_H
+
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+
+
+// Class and function definitions
+namespace trn {
+    // Files are a 16 byte header ("OOCGPOS" and a zero, uint32 version, uint32 record size)
+    // followed by fixed size little endian records:
+    //   32 bytes of squares (a1 to h8, two per byte with the lower numbered square in the low four bits,
+    //   0 empty, 1-6 white pawn to king, 9-14 black pawn to king), side to move (0 white, 1 black),
+    //   result for white (0 loss, 1 draw, 2 win) and an int16 search score for white (0 if unknown)
+    const std::uint32_t training_data_version{1};
+    const int header_size{16};
+    const int record_size{36};
+
+    struct position_record
+    {
+        std::uint8_t squares[32]{};
+        std::uint8_t side_to_move{};
+        std::uint8_t result{};
+        std::int16_t score{};
+    };
+
+    position_record make_record(const brd::board& chess_board, pcs::color side_to_move, int result, int score);
+    // Castling rights and en passant aren't stored, kings and rooks count as moved
+    std::string record_to_fen(const position_record& record);
+    double result_for_white(const position_record& record);
+    std::vector<position_record> read_training_data(std::string file_name);
+    // Converts a text file of FENs labelled with game results, returning the number of positions written
+    long long pack_labelled_positions(std::string text_file_name, std::string data_file_name);
+
+
+    class training_data_writer
+    {
+    private:
+        std::ofstream data_file;
+        long long records_written{};
+
+    public:
+        // Constructors
+        training_data_writer(std::string file_name);
+        // Appending adds records to an existing file, or starts a new one if there is none
+        training_data_writer(std::string file_name, bool append);
+        training_data_writer(const training_data_writer &writer_to_copy) = delete;
+        training_data_writer& operator=(const training_data_writer &writer_to_copy) = delete;
+        // Destructor
+        ~training_data_writer(){}
+
+        // Member functions
+        void write(const position_record& record);
+        void flush();
+        void close();
+        long long get_records_written() const { return records_written; }
+    };
+}
+
+#endif
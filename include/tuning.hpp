@@ -0,0 +1,75 @@
+// object-oriented-chess-game/tuning.hpp
+//
+// Header file for tuning the evaluation weights
+// on positions labelled with game results
+//
+// Author: Jason Dominguez
+
+
+#ifndef TUNING_H
+#define TUNING_H
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include "evaluation.hpp"
+#include "thread_pool.hpp"
+
+
+// Class and function definitions
+namespace tun {
+    struct tuning_options
+    {
+        int epochs{200};
+        // Largest change to a weight per epoch, in centipawns
+        double learning_rate{1.0};
+        // Zero runs on the program's shared pool, with one thread per hardware core
+        int number_of_threads{0};
+        // Positions where captures are still to be played out are left out, their static
+        // evaluation says little about the result
+        bool quiet_positions_only{true};
+    };
+
+
+    // Texel tuning: the evaluation is turned into an expected result with a sigmoid and the weights
+    // are moved to minimise the squared difference from the actual results of the games
+    class evaluation_tuner
+    {
+    private:
+        // Evaluation features of each position, so epochs never need a board
+        struct feature_term
+        {
+            std::uint16_t parameter;
+            std::int16_t count;
+        };
+
+        tuning_options options;
+        std::shared_ptr<thr::thread_pool> worker_pool;
+        // Terms of every position end to end: position i has middlegame terms from term_offsets[2*i]
+        // and endgame terms from term_offsets[2*i + 1] up to term_offsets[2*i + 2]
+        std::vector<feature_term> terms;
+        std::vector<std::uint32_t> term_offsets{0};
+        std::vector<std::uint8_t> game_phases;
+        std::vector<float> results;
+        double scaling_constant{1.0};
+
+        size_t get_number_of_chunks() const;
+        double compute_error(const std::vector<double>& parameters, std::vector<double>* gradient);
+
+    public:
+        // Constructors
+        evaluation_tuner(const tuning_options& tuning_settings);
+        // Destructor
+        ~evaluation_tuner(){}
+
+        // Member functions
+        size_t load_positions(std::string file_name);
+        size_t get_number_of_positions() const { return results.size(); }
+        double fit_scaling_constant(const evl::evaluation_weights& weights);
+        evl::evaluation_weights tune(const evl::evaluation_weights& initial_weights);
+    };
+}
+
+#endif
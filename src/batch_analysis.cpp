@@ -0,0 +1,167 @@
+// object-oriented-chess-game/batch_analysis.cpp
+//
+// Source file for analysing a list of positions
+// on every core without any interaction
+//
+// Author: Jason Dominguez
+
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <exception>
+#include <algorithm>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "thread_pool.hpp"
+#include "batch_analysis.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    struct batch_position
+    {
+        int line_number{};
+        std::string fen;
+        // Filled in by whichever thread analyses the position
+        std::string json;
+        long long nodes_searched{};
+        bool is_valid{false};
+        bool is_done{false};
+    };
+
+
+    std::string escape_json_string(const std::string& text) {
+        std::stringstream escaped_text;
+        for (auto character_iterator = text.begin() ; character_iterator != text.end() ; character_iterator++) {
+            char character{*character_iterator};
+            switch (character) {
+                case '"': escaped_text << "\\\""; break;
+                case '\\': escaped_text << "\\\\"; break;
+                case '\n': escaped_text << "\\n"; break;
+                case '\r': escaped_text << "\\r"; break;
+                case '\t': escaped_text << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(character) < 0x20) {
+                        escaped_text << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                                     << static_cast<int>(character) << std::dec;
+                    } else {
+                        escaped_text << character;
+                    }
+            }
+        }
+        return escaped_text.str();
+    }
+
+
+    void analyse_position(search& position_search, const batch_analysis_options& options, batch_position& position) {
+        std::stringstream json;
+        json << "{\"line\":" << position.line_number << ",\"fen\":\"" << escape_json_string(position.fen) << "\"";
+        try {
+            std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> fen_position{brd::read_fen(position.fen)};
+            brd::board chess_board{fen_position.first};
+
+            // Starting every position from empty tables makes the results independent of which
+            // thread happened to analyse which positions before it
+            position_search.clear();
+            auto start_time = std::chrono::steady_clock::now();
+            std::pair<move, int> result{position_search.find_best_move(chess_board, fen_position.second, options.max_depth)};
+            double milliseconds{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count()};
+
+            json << ",\"best_move\":";
+            if (result.first.is_valid()) {
+                json << "\"" << move_to_string(result.first) << "\"";
+            } else {
+                // Checkmate or stalemate already
+                json << "null";
+            }
+            int score{result.second};
+            if (score > checkmate_score - max_mate_ply) {
+                json << ",\"score_mate\":" << (checkmate_score - score + 1)/2;
+            } else if (score < -checkmate_score + max_mate_ply) {
+                json << ",\"score_mate\":" << -(checkmate_score + score)/2;
+            } else {
+                json << ",\"score_cp\":" << score;
+            }
+            position.nodes_searched = position_search.get_nodes_searched();
+            json << ",\"depth\":" << position_search.get_completed_depth() << ",\"nodes\":" << position.nodes_searched
+                 << ",\"time_ms\":" << std::fixed << std::setprecision(1) << milliseconds << "}";
+            position.is_valid = true;
+        } catch (const std::exception& e) {
+            json << ",\"error\":\"" << escape_json_string(e.what()) << "\"}";
+        }
+        position.json = json.str();
+    }
+
+
+    batch_analysis_summary analyse_positions(std::istream& fen_input, std::ostream& json_output,
+                                             const batch_analysis_options& options) {
+        std::vector<batch_position> positions;
+        std::string line;
+        for (int line_number{1} ; std::getline(fen_input, line) ; line_number++) {
+            size_t first{line.find_first_not_of(" \t\r")};
+            if (first == std::string::npos) {
+                continue;
+            }
+            batch_position position{};
+            position.line_number = line_number;
+            position.fen = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+            positions.push_back(position);
+        }
+
+        // Each thread keeps one search for all of its positions and takes the next position when it finishes
+        // one. Results are written by whichever thread completes the earliest position still outstanding
+        std::shared_ptr<thr::thread_pool> worker_pool{thr::make_thread_pool(std::max(0, options.number_of_threads))};
+        batch_analysis_summary summary{};
+        std::mutex output_mutex;
+        size_t next_to_write{};
+        std::atomic<size_t> next_position{0};
+        auto start_time = std::chrono::steady_clock::now();
+        size_t number_of_tasks{std::min(worker_pool->get_number_of_threads(), positions.size())};
+        std::vector<std::future<void>> tasks;
+        for (size_t thread{} ; thread < number_of_tasks ; thread++) {
+            tasks.push_back(worker_pool->submit([&]() {
+                std::unique_ptr<search> position_search{new search{}};
+                position_search->resize_transposition_table(options.transposition_table_entries);
+                search_limits limits{};
+                limits.max_nodes = options.max_nodes;
+                limits.max_time_ms = options.max_time_ms;
+                position_search->set_limits(limits);
+                for (size_t i{next_position++} ; i < positions.size() ; i = next_position++) {
+                    analyse_position(*position_search, options, positions[i]);
+
+                    std::lock_guard<std::mutex> output_lock{output_mutex};
+                    positions[i].is_done = true;
+                    while (next_to_write < positions.size() && positions[next_to_write].is_done) {
+                        batch_position& finished_position{positions[next_to_write]};
+                        json_output << finished_position.json << "\n";
+                        if (finished_position.is_valid) {
+                            summary.positions_analysed++;
+                            summary.nodes_searched += finished_position.nodes_searched;
+                        } else {
+                            summary.invalid_positions++;
+                        }
+                        // Results are kept only until they are written
+                        std::string().swap(finished_position.json);
+                        next_to_write++;
+                    }
+                    json_output.flush();
+                }
+            }));
+        }
+        for (auto task_iterator = tasks.begin() ; task_iterator != tasks.end() ; task_iterator++) {
+            worker_pool->wait(*task_iterator);
+        }
+        summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        return summary;
+    }
+}
@@ -0,0 +1,479 @@
+// object-oriented-chess-game/batch_evaluation.cpp
+//
+// Source file for evaluating large batches of
+// positions with vector instructions
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "evaluation.hpp"
+#include "batch_evaluation.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BATCH_X86_SIMD
+#endif
+
+
+// Class and function definitions
+namespace evl {
+    // Values of each piece code on each square, from white's point of view, laid out so a
+    // kernel can look up a whole vector of codes on one square with a single gather
+    struct batch_tables
+    {
+        std::int32_t square_values[2][64][16]{};
+        std::int32_t phase_values[16]{};
+
+        batch_tables() {
+            const char piece_symbols[6]{'p', 'N', 'B', 'R', 'Q', 'K'};
+            for (int piece{} ; piece < 6 ; piece++) {
+                for (int stage{} ; stage < 2 ; stage++) {
+                    for (int i{} ; i < 8*8 ; i++) {
+                        square_values[stage][i][piece + 1] = piece_square_value(piece_symbols[piece], pcs::white, i,
+                                                                                static_cast<game_stage>(stage));
+                        square_values[stage][i][piece + 9] = -piece_square_value(piece_symbols[piece], pcs::black, i,
+                                                                                 static_cast<game_stage>(stage));
+                    }
+                }
+                phase_values[piece + 1] = piece_phase(piece_symbols[piece]);
+                phase_values[piece + 9] = piece_phase(piece_symbols[piece]);
+            }
+        }
+    };
+
+
+    // Mobility is counted one direction at a time. A piece attacks at most one square in each
+    // direction (or one ray, and rays in the same direction stop at the first piece so never
+    // overlap), so adding up each direction's count gives every piece's mobility exactly.
+    // Directions are board index steps with the file mask that stops them wrapping round the board
+    const std::uint64_t not_a_file{0xfefefefefefefefeULL};
+    const std::uint64_t not_h_file{0x7f7f7f7f7f7f7f7fULL};
+    const std::uint64_t not_ab_files{0xfcfcfcfcfcfcfcfcULL};
+    const std::uint64_t not_gh_files{0x3f3f3f3f3f3f3f3fULL};
+    const std::uint64_t all_files{0xffffffffffffffffULL};
+
+    struct direction
+    {
+        int step;
+        std::uint64_t file_mask;
+    };
+
+    const direction knight_directions[8]{{17, not_a_file}, {15, not_h_file}, {10, not_ab_files}, {6, not_gh_files},
+                                         {-6, not_ab_files}, {-10, not_gh_files}, {-15, not_a_file}, {-17, not_h_file}};
+    const direction diagonal_directions[4]{{9, not_a_file}, {7, not_h_file}, {-7, not_a_file}, {-9, not_h_file}};
+    const direction straight_directions[4]{{8, all_files}, {-8, all_files}, {1, not_a_file}, {-1, not_h_file}};
+
+
+    // Scalar versions, used when the CPU has no suitable vector instructions
+    std::uint64_t shift_scalar(std::uint64_t bitboard, int step) {
+        return step > 0 ? bitboard << step : bitboard >> -step;
+    }
+
+
+    int count_bits_scalar(std::uint64_t bitboard) {
+        bitboard = bitboard - ((bitboard >> 1) & 0x5555555555555555ULL);
+        bitboard = (bitboard & 0x3333333333333333ULL) + ((bitboard >> 2) & 0x3333333333333333ULL);
+        bitboard = (bitboard + (bitboard >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return static_cast<int>((bitboard*0x0101010101010101ULL) >> 56);
+    }
+
+
+    std::uint64_t slider_attacks_scalar(std::uint64_t sliders, std::uint64_t empty_squares, const direction& ray) {
+        // Kogge-Stone fill along the ray through empty squares, then one more step onto the blocker
+        std::uint64_t propagators{empty_squares & ray.file_mask};
+        sliders |= propagators & shift_scalar(sliders, ray.step);
+        propagators &= shift_scalar(propagators, ray.step);
+        sliders |= propagators & shift_scalar(sliders, 2*ray.step);
+        propagators &= shift_scalar(propagators, 2*ray.step);
+        sliders |= propagators & shift_scalar(sliders, 4*ray.step);
+        return shift_scalar(sliders, ray.step) & ray.file_mask;
+    }
+
+
+    int side_mobility_scalar(const std::uint64_t* bitboards[number_of_batch_bitboards], size_t p, int first_bitboard) {
+        std::uint64_t empty_squares{~bitboards[occupied_squares][p]};
+        std::uint64_t not_own_pieces{~bitboards[first_bitboard][p]};
+        int mobility{};
+        for (int i{} ; i < 8 ; i++) {
+            mobility += count_bits_scalar(shift_scalar(bitboards[first_bitboard + 1][p], knight_directions[i].step) &
+                                          knight_directions[i].file_mask & not_own_pieces);
+        }
+        for (int i{} ; i < 4 ; i++) {
+            mobility += count_bits_scalar(slider_attacks_scalar(bitboards[first_bitboard + 2][p], empty_squares,
+                                                                diagonal_directions[i]) & not_own_pieces);
+            mobility += count_bits_scalar(slider_attacks_scalar(bitboards[first_bitboard + 3][p], empty_squares,
+                                                                straight_directions[i]) & not_own_pieces);
+        }
+        return mobility;
+    }
+
+
+    void evaluate_batch_scalar(const position_batch& batch, const batch_tables& tables, batch_evaluation& evaluation) {
+        const std::uint64_t* bitboards[number_of_batch_bitboards];
+        for (int i{} ; i < number_of_batch_bitboards ; i++) {
+            bitboards[i] = batch.get_bitboards(static_cast<batch_bitboard>(i));
+        }
+        for (size_t p{} ; p < batch.size() ; p++) {
+            int middlegame_score{batch.get_pawn_scores(middlegame)[p]};
+            int endgame_score{batch.get_pawn_scores(endgame)[p]};
+            int game_phase{};
+            for (int i{} ; i < 8*8 ; i++) {
+                int piece_code{batch.get_piece_codes(i)[p]};
+                middlegame_score += tables.square_values[middlegame][i][piece_code];
+                endgame_score += tables.square_values[endgame][i][piece_code];
+                game_phase += tables.phase_values[piece_code];
+            }
+            evaluation.scores[p] = tapered_score(middlegame_score, endgame_score, game_phase);
+            evaluation.mobility[p] = side_mobility_scalar(bitboards, p, white_pieces) -
+                                     side_mobility_scalar(bitboards, p, black_pieces);
+        }
+    }
+
+
+#ifdef BATCH_X86_SIMD
+    // AVX2: eight positions per instruction for the piece-square sums, four for the 64 bit bitboards
+    __attribute__((target("avx2")))
+    __m256i load_avx2(const void* values) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    }
+
+
+    __attribute__((target("avx2")))
+    __m256i shift_avx2(__m256i bitboards, int step) {
+        return step > 0 ? _mm256_sll_epi64(bitboards, _mm_cvtsi32_si128(step)) :
+                          _mm256_srl_epi64(bitboards, _mm_cvtsi32_si128(-step));
+    }
+
+
+    __attribute__((target("avx2")))
+    __m256i count_bits_avx2(__m256i bitboards) {
+        // Each nibble's count comes from a 16 entry table, then the bytes of each bitboard are added up
+        const __m256i nibble_counts{_mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4)};
+        const __m256i low_nibbles{_mm256_set1_epi8(0x0f)};
+        __m256i byte_counts{_mm256_add_epi8(
+            _mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(bitboards, low_nibbles)),
+            _mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(_mm256_srli_epi16(bitboards, 4), low_nibbles)))};
+        return _mm256_sad_epu8(byte_counts, _mm256_setzero_si256());
+    }
+
+
+    __attribute__((target("avx2")))
+    __m256i slider_attacks_avx2(__m256i sliders, __m256i empty_squares, const direction& ray) {
+        __m256i file_mask{_mm256_set1_epi64x(static_cast<long long>(ray.file_mask))};
+        __m256i propagators{_mm256_and_si256(empty_squares, file_mask)};
+        sliders = _mm256_or_si256(sliders, _mm256_and_si256(propagators, shift_avx2(sliders, ray.step)));
+        propagators = _mm256_and_si256(propagators, shift_avx2(propagators, ray.step));
+        sliders = _mm256_or_si256(sliders, _mm256_and_si256(propagators, shift_avx2(sliders, 2*ray.step)));
+        propagators = _mm256_and_si256(propagators, shift_avx2(propagators, 2*ray.step));
+        sliders = _mm256_or_si256(sliders, _mm256_and_si256(propagators, shift_avx2(sliders, 4*ray.step)));
+        return _mm256_and_si256(shift_avx2(sliders, ray.step), file_mask);
+    }
+
+
+    __attribute__((target("avx2")))
+    __m256i side_mobility_avx2(const std::uint64_t* bitboards[number_of_batch_bitboards], size_t p, int first_bitboard) {
+        const __m256i all_squares{_mm256_set1_epi64x(-1)};
+        __m256i empty_squares{_mm256_xor_si256(load_avx2(bitboards[occupied_squares] + p), all_squares)};
+        __m256i not_own_pieces{_mm256_xor_si256(load_avx2(bitboards[first_bitboard] + p), all_squares)};
+        __m256i knights{load_avx2(bitboards[first_bitboard + 1] + p)};
+        __m256i diagonal_sliders{load_avx2(bitboards[first_bitboard + 2] + p)};
+        __m256i straight_sliders{load_avx2(bitboards[first_bitboard + 3] + p)};
+        __m256i mobility{_mm256_setzero_si256()};
+        for (int i{} ; i < 8 ; i++) {
+            __m256i file_mask{_mm256_set1_epi64x(static_cast<long long>(knight_directions[i].file_mask))};
+            __m256i attacks{_mm256_and_si256(shift_avx2(knights, knight_directions[i].step), file_mask)};
+            mobility = _mm256_add_epi64(mobility, count_bits_avx2(_mm256_and_si256(attacks, not_own_pieces)));
+        }
+        for (int i{} ; i < 4 ; i++) {
+            __m256i attacks{slider_attacks_avx2(diagonal_sliders, empty_squares, diagonal_directions[i])};
+            mobility = _mm256_add_epi64(mobility, count_bits_avx2(_mm256_and_si256(attacks, not_own_pieces)));
+            attacks = slider_attacks_avx2(straight_sliders, empty_squares, straight_directions[i]);
+            mobility = _mm256_add_epi64(mobility, count_bits_avx2(_mm256_and_si256(attacks, not_own_pieces)));
+        }
+        return mobility;
+    }
+
+
+    __attribute__((target("avx2")))
+    void evaluate_batch_avx2(const position_batch& batch, const batch_tables& tables, batch_evaluation& evaluation) {
+        const __m256i max_phase{_mm256_set1_epi32(max_game_phase)};
+        const __m256 phase_divisor{_mm256_set1_ps(static_cast<float>(max_game_phase))};
+        // Padding makes every group of eight complete, the extra results are dropped at the end
+        for (size_t p{} ; p < batch.get_padded_size() ; p += 8) {
+            __m256i middlegame_scores{load_avx2(batch.get_pawn_scores(middlegame) + p)};
+            __m256i endgame_scores{load_avx2(batch.get_pawn_scores(endgame) + p)};
+            __m256i game_phases{_mm256_setzero_si256()};
+            for (int i{} ; i < 8*8 ; i++) {
+                __m256i piece_codes{_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(batch.get_piece_codes(i) + p)))};
+                middlegame_scores = _mm256_add_epi32(middlegame_scores,
+                                                     _mm256_i32gather_epi32(tables.square_values[middlegame][i], piece_codes, 4));
+                endgame_scores = _mm256_add_epi32(endgame_scores,
+                                                  _mm256_i32gather_epi32(tables.square_values[endgame][i], piece_codes, 4));
+                game_phases = _mm256_add_epi32(game_phases, _mm256_i32gather_epi32(tables.phase_values, piece_codes, 4));
+            }
+            // Same blend as tapered_score. The sums are far below 2^24, so the float division
+            // truncated towards zero gives exactly the integer division
+            game_phases = _mm256_min_epi32(game_phases, max_phase);
+            __m256i blended{_mm256_add_epi32(_mm256_mullo_epi32(middlegame_scores, game_phases),
+                                             _mm256_mullo_epi32(endgame_scores, _mm256_sub_epi32(max_phase, game_phases)))};
+            __m256i scores{_mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(blended), phase_divisor))};
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(evaluation.scores.data() + p), scores);
+        }
+
+        const std::uint64_t* bitboards[number_of_batch_bitboards];
+        for (int i{} ; i < number_of_batch_bitboards ; i++) {
+            bitboards[i] = batch.get_bitboards(static_cast<batch_bitboard>(i));
+        }
+        for (size_t p{} ; p < batch.get_padded_size() ; p += 4) {
+            std::int64_t mobility[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(mobility),
+                                _mm256_sub_epi64(side_mobility_avx2(bitboards, p, white_pieces),
+                                                 side_mobility_avx2(bitboards, p, black_pieces)));
+            for (int i{} ; i < 4 ; i++) {
+                evaluation.mobility[p + i] = static_cast<int>(mobility[i]);
+            }
+        }
+    }
+
+
+    // AVX-512: sixteen positions per instruction for the piece-square sums, eight for the bitboards
+    // The unmasked intrinsics start from an undefined vector, which gcc warns may be used uninitialized,
+    // so these use the masked forms with every lane set and a zero base
+    __attribute__((target("avx512f,avx512bw")))
+    __m512i shift_avx512(__m512i bitboards, int step) {
+        return step > 0 ? _mm512_mask_sll_epi64(_mm512_setzero_si512(), 0xff, bitboards, _mm_cvtsi32_si128(step)) :
+                          _mm512_mask_srl_epi64(_mm512_setzero_si512(), 0xff, bitboards, _mm_cvtsi32_si128(-step));
+    }
+
+
+    __attribute__((target("avx512f,avx512bw")))
+    __m512i count_bits_avx512(__m512i bitboards) {
+        const __m512i nibble_counts{_mm512_mask_broadcast_i32x4(
+            _mm512_setzero_si512(), 0xffff, _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4))};
+        const __m512i low_nibbles{_mm512_set1_epi8(0x0f)};
+        __m512i byte_counts{_mm512_add_epi8(
+            _mm512_shuffle_epi8(nibble_counts, _mm512_and_si512(bitboards, low_nibbles)),
+            _mm512_shuffle_epi8(nibble_counts, _mm512_and_si512(_mm512_srli_epi16(bitboards, 4), low_nibbles)))};
+        return _mm512_sad_epu8(byte_counts, _mm512_setzero_si512());
+    }
+
+
+    __attribute__((target("avx512f,avx512bw")))
+    __m512i slider_attacks_avx512(__m512i sliders, __m512i empty_squares, const direction& ray) {
+        __m512i file_mask{_mm512_set1_epi64(static_cast<long long>(ray.file_mask))};
+        __m512i propagators{_mm512_and_si512(empty_squares, file_mask)};
+        sliders = _mm512_or_si512(sliders, _mm512_and_si512(propagators, shift_avx512(sliders, ray.step)));
+        propagators = _mm512_and_si512(propagators, shift_avx512(propagators, ray.step));
+        sliders = _mm512_or_si512(sliders, _mm512_and_si512(propagators, shift_avx512(sliders, 2*ray.step)));
+        propagators = _mm512_and_si512(propagators, shift_avx512(propagators, 2*ray.step));
+        sliders = _mm512_or_si512(sliders, _mm512_and_si512(propagators, shift_avx512(sliders, 4*ray.step)));
+        return _mm512_and_si512(shift_avx512(sliders, ray.step), file_mask);
+    }
+
+
+    __attribute__((target("avx512f,avx512bw")))
+    __m512i side_mobility_avx512(const std::uint64_t* bitboards[number_of_batch_bitboards], size_t p, int first_bitboard) {
+        const __m512i all_squares{_mm512_set1_epi64(-1)};
+        __m512i empty_squares{_mm512_xor_si512(_mm512_loadu_si512(bitboards[occupied_squares] + p), all_squares)};
+        __m512i not_own_pieces{_mm512_xor_si512(_mm512_loadu_si512(bitboards[first_bitboard] + p), all_squares)};
+        __m512i knights{_mm512_loadu_si512(bitboards[first_bitboard + 1] + p)};
+        __m512i diagonal_sliders{_mm512_loadu_si512(bitboards[first_bitboard + 2] + p)};
+        __m512i straight_sliders{_mm512_loadu_si512(bitboards[first_bitboard + 3] + p)};
+        __m512i mobility{_mm512_setzero_si512()};
+        for (int i{} ; i < 8 ; i++) {
+            __m512i file_mask{_mm512_set1_epi64(static_cast<long long>(knight_directions[i].file_mask))};
+            __m512i attacks{_mm512_and_si512(shift_avx512(knights, knight_directions[i].step), file_mask)};
+            mobility = _mm512_add_epi64(mobility, count_bits_avx512(_mm512_and_si512(attacks, not_own_pieces)));
+        }
+        for (int i{} ; i < 4 ; i++) {
+            __m512i attacks{slider_attacks_avx512(diagonal_sliders, empty_squares, diagonal_directions[i])};
+            mobility = _mm512_add_epi64(mobility, count_bits_avx512(_mm512_and_si512(attacks, not_own_pieces)));
+            attacks = slider_attacks_avx512(straight_sliders, empty_squares, straight_directions[i]);
+            mobility = _mm512_add_epi64(mobility, count_bits_avx512(_mm512_and_si512(attacks, not_own_pieces)));
+        }
+        return mobility;
+    }
+
+
+    __attribute__((target("avx512f,avx512bw")))
+    void evaluate_batch_avx512(const position_batch& batch, const batch_tables& tables, batch_evaluation& evaluation) {
+        const __m512i max_phase{_mm512_set1_epi32(max_game_phase)};
+        const __m512 phase_divisor{_mm512_set1_ps(static_cast<float>(max_game_phase))};
+        const __m512i zeros{_mm512_setzero_si512()};
+        for (size_t p{} ; p < batch.get_padded_size() ; p += 16) {
+            __m512i middlegame_scores{_mm512_loadu_si512(batch.get_pawn_scores(middlegame) + p)};
+            __m512i endgame_scores{_mm512_loadu_si512(batch.get_pawn_scores(endgame) + p)};
+            __m512i game_phases{zeros};
+            for (int i{} ; i < 8*8 ; i++) {
+                __m512i piece_codes{_mm512_mask_cvtepu8_epi32(zeros, 0xffff, _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(batch.get_piece_codes(i) + p)))};
+                middlegame_scores = _mm512_add_epi32(middlegame_scores,
+                                                     _mm512_mask_i32gather_epi32(zeros, 0xffff, piece_codes, tables.square_values[middlegame][i], 4));
+                endgame_scores = _mm512_add_epi32(endgame_scores,
+                                                  _mm512_mask_i32gather_epi32(zeros, 0xffff, piece_codes, tables.square_values[endgame][i], 4));
+                game_phases = _mm512_add_epi32(game_phases, _mm512_mask_i32gather_epi32(zeros, 0xffff, piece_codes, tables.phase_values, 4));
+            }
+            game_phases = _mm512_mask_min_epi32(zeros, 0xffff, game_phases, max_phase);
+            __m512i blended{_mm512_add_epi32(_mm512_mullo_epi32(middlegame_scores, game_phases),
+                                             _mm512_mullo_epi32(endgame_scores, _mm512_sub_epi32(max_phase, game_phases)))};
+            __m512 scaled{_mm512_div_ps(_mm512_mask_cvtepi32_ps(_mm512_setzero_ps(), 0xffff, blended), phase_divisor)};
+            __m512i scores{_mm512_mask_cvttps_epi32(zeros, 0xffff, scaled)};
+            _mm512_storeu_si512(evaluation.scores.data() + p, scores);
+        }
+
+        const std::uint64_t* bitboards[number_of_batch_bitboards];
+        for (int i{} ; i < number_of_batch_bitboards ; i++) {
+            bitboards[i] = batch.get_bitboards(static_cast<batch_bitboard>(i));
+        }
+        for (size_t p{} ; p < batch.get_padded_size() ; p += 8) {
+            __m512i mobility{_mm512_sub_epi64(side_mobility_avx512(bitboards, p, white_pieces),
+                                              side_mobility_avx512(bitboards, p, black_pieces))};
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(evaluation.mobility.data() + p),
+                                _mm512_mask_cvtepi64_epi32(_mm256_setzero_si256(), 0xff, mobility));
+        }
+    }
+#endif
+
+
+    batch_kernel get_batch_kernel() {
+        // Checked once, the result can't change while the program runs
+        static const batch_kernel kernel = []() -> batch_kernel {
+#ifdef BATCH_X86_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+                return avx512_batch_kernel;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                return avx2_batch_kernel;
+            }
+#endif
+            return scalar_batch_kernel;
+        }();
+        return kernel;
+    }
+
+
+    std::string batch_kernel_to_string(batch_kernel kernel) {
+        switch (kernel) {
+            case avx512_batch_kernel:
+                return "AVX-512";
+            case avx2_batch_kernel:
+                return "AVX2";
+            default:
+                return "scalar";
+        }
+    }
+
+
+    batch_evaluation evaluate_batch(const position_batch& batch) {
+        return evaluate_batch(batch, get_batch_kernel());
+    }
+
+
+    batch_evaluation evaluate_batch(const position_batch& batch, batch_kernel kernel) {
+        if (kernel > get_batch_kernel()) {
+            throw std::invalid_argument("Batch evaluation kernel is not supported by this CPU");
+        }
+        // Tables follow the current weights, and are cheap next to a batch of any size
+        batch_tables tables{};
+        // Results are sized to the padding so kernels can store whole vectors
+        batch_evaluation evaluation{};
+        evaluation.scores.resize(batch.get_padded_size());
+        evaluation.mobility.resize(batch.get_padded_size());
+        switch (kernel) {
+#ifdef BATCH_X86_SIMD
+            case avx512_batch_kernel:
+                evaluate_batch_avx512(batch, tables, evaluation);
+                break;
+            case avx2_batch_kernel:
+                evaluate_batch_avx2(batch, tables, evaluation);
+                break;
+#endif
+            default:
+                evaluate_batch_scalar(batch, tables, evaluation);
+        }
+        evaluation.scores.resize(batch.size());
+        evaluation.mobility.resize(batch.size());
+        return evaluation;
+    }
+}
+
+
+void evl::position_batch::grow(size_t new_padded_size) {
+    // Squares are stored one after another, so each square's run of codes moves to its new place
+    std::vector<std::uint8_t> new_piece_codes(64*new_padded_size);
+    for (int i{} ; i < 8*8 ; i++) {
+        std::copy(piece_codes.begin() + i*padded_size, piece_codes.begin() + i*padded_size + number_of_positions,
+                  new_piece_codes.begin() + i*new_padded_size);
+    }
+    piece_codes.swap(new_piece_codes);
+    for (int i{} ; i < number_of_batch_bitboards ; i++) {
+        bitboards[i].resize(new_padded_size);
+    }
+    for (int stage{} ; stage < 2 ; stage++) {
+        pawn_scores[stage].resize(new_padded_size);
+    }
+    padded_size = new_padded_size;
+}
+
+
+void evl::position_batch::reserve(size_t expected_positions) {
+    size_t new_padded_size{(expected_positions + batch_lane_count - 1)/batch_lane_count*batch_lane_count};
+    if (new_padded_size > padded_size) {
+        grow(new_padded_size);
+    }
+}
+
+
+void evl::position_batch::add(const brd::board& chess_board) {
+    if (number_of_positions == padded_size) {
+        grow(std::max<size_t>(batch_lane_count, 2*padded_size));
+    }
+    size_t p{number_of_positions};
+    for (int i{} ; i < number_of_batch_bitboards ; i++) {
+        bitboards[i][p] = 0;
+    }
+    for (int i{} ; i < 8*8 ; i++) {
+        pcs::chess_piece* piece{chess_board.get_piece(i)};
+        if (!piece) {
+            piece_codes[i*padded_size + p] = 0;
+            continue;
+        }
+        bool is_white{piece->get_piece_color() == pcs::white};
+        int piece_index{piece_type(piece->get_symbol())};
+        piece_codes[i*padded_size + p] = static_cast<std::uint8_t>(piece_index + 1 + (is_white ? 0 : 8));
+
+        std::uint64_t square{1ULL << i};
+        int first_bitboard{is_white ? white_pieces : black_pieces};
+        bitboards[occupied_squares][p] |= square;
+        bitboards[first_bitboard][p] |= square;
+        char piece_symbol{piece->get_symbol()};
+        if (piece_symbol == 'N') {
+            bitboards[first_bitboard + 1][p] |= square;
+        }
+        if (piece_symbol == 'B' || piece_symbol == 'Q') {
+            bitboards[first_bitboard + 2][p] |= square;
+        }
+        if (piece_symbol == 'R' || piece_symbol == 'Q') {
+            bitboards[first_bitboard + 3][p] |= square;
+        }
+    }
+    pawn_structure_score pawn_score{pawn_table.get_score(chess_board)};
+    pawn_scores[middlegame][p] = pawn_score.middlegame;
+    pawn_scores[endgame][p] = pawn_score.endgame;
+    number_of_positions++;
+}
+
+
+void evl::position_batch::clear() {
+    // Storage is kept for the next batch, padding lanes are overwritten as positions are added
+    number_of_positions = 0;
+}
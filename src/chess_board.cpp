@@ -11,8 +11,14 @@
 #include <vector>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <cctype>
 #include "chess_board.hpp"
 #include "chess_pieces.hpp"
+#include "evaluation.hpp"
 
 
 // Class and function definitions
@@ -168,15 +174,147 @@ namespace brd {
 
         return std::move(chess_board);
     }
+
+
+    std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> read_fen(std::string fen) {
+        std::stringstream fen_input{fen};
+        std::string placement, side, castling, en_passant;
+        fen_input >> placement >> side >> castling >> en_passant;
+        if (placement.empty()) {
+            throw std::invalid_argument("FEN has no piece placement");
+        }
+
+        // Placement runs from a8 to h8, then down to a1 to h1
+        std::vector<std::unique_ptr<pcs::chess_piece>> chess_board(8*8);
+        int row{7}, col{};
+        int white_kings{}, black_kings{};
+        for (auto character_iterator = placement.begin() ; character_iterator != placement.end() ; character_iterator++) {
+            char character{*character_iterator};
+            if (character == '/') {
+                if (col != 8 || row == 0) {
+                    throw std::invalid_argument("FEN rank does not have eight squares");
+                }
+                row--;
+                col = 0;
+                continue;
+            }
+            if (character >= '1' && character <= '8') {
+                col += character - '0';
+                if (col > 8) {
+                    throw std::invalid_argument("FEN rank does not have eight squares");
+                }
+                continue;
+            }
+            if (col >= 8) {
+                throw std::invalid_argument("FEN rank does not have eight squares");
+            }
+
+            pcs::color piece_color{std::isupper(static_cast<unsigned char>(character)) ? pcs::white : pcs::black};
+            int position{row*8 + col};
+            // Castling rights and double pawn moves are set from the other fields below
+            switch (std::tolower(static_cast<unsigned char>(character))) {
+                case 'p':
+                    if (row == 0 || row == 7) {
+                        throw std::invalid_argument("FEN has a pawn on the first or last rank");
+                    }
+                    chess_board[position] = std::make_unique<pcs::pawn>(pcs::pawn(piece_color, position,
+                                                                                  row != (piece_color == pcs::white ? 1 : 6)));
+                    break;
+                case 'n': chess_board[position] = std::make_unique<pcs::knight>(pcs::knight(piece_color, position, true)); break;
+                case 'b': chess_board[position] = std::make_unique<pcs::bishop>(pcs::bishop(piece_color, position, true)); break;
+                case 'r': chess_board[position] = std::make_unique<pcs::rook>(pcs::rook(piece_color, position, true)); break;
+                case 'q': chess_board[position] = std::make_unique<pcs::queen>(pcs::queen(piece_color, position, true)); break;
+                case 'k':
+                    chess_board[position] = std::make_unique<pcs::king>(pcs::king(piece_color, position, true));
+                    piece_color == pcs::white ? white_kings++ : black_kings++;
+                    break;
+                default:
+                    throw std::invalid_argument("FEN has an unknown piece");
+            }
+            col++;
+        }
+        if (row != 0 || col != 8) {
+            throw std::invalid_argument("FEN does not have eight ranks");
+        }
+        if (white_kings != 1 || black_kings != 1) {
+            throw std::invalid_argument("FEN must have one king of each color");
+        }
+
+        pcs::color side_to_move{pcs::white};
+        if (side == "b") {
+            side_to_move = pcs::black;
+        } else if (!side.empty() && side != "w") {
+            throw std::invalid_argument("FEN side to move must be w or b");
+        }
+
+        // Castling is allowed while the king and rook have not moved, as in a game
+        auto allow_castling = [&chess_board](int king_position, int rook_position, pcs::color piece_color) {
+            pcs::chess_piece* king{chess_board[king_position].get()};
+            pcs::chess_piece* rook{chess_board[rook_position].get()};
+            if (!king || king->get_symbol() != 'K' || king->get_piece_color() != piece_color ||
+                !rook || rook->get_symbol() != 'R' || rook->get_piece_color() != piece_color) {
+                throw std::invalid_argument("FEN castling rights don't match the king and rook positions");
+            }
+            chess_board[king_position] = std::make_unique<pcs::king>(pcs::king(piece_color, king_position, false));
+            chess_board[rook_position] = std::make_unique<pcs::rook>(pcs::rook(piece_color, rook_position, false));
+        };
+        if (castling != "-") {
+            for (auto character_iterator = castling.begin() ; character_iterator != castling.end() ; character_iterator++) {
+                if (*character_iterator == 'K') { allow_castling(4, 7, pcs::white); }
+                else if (*character_iterator == 'Q') { allow_castling(4, 0, pcs::white); }
+                else if (*character_iterator == 'k') { allow_castling(60, 63, pcs::black); }
+                else if (*character_iterator == 'q') { allow_castling(60, 56, pcs::black); }
+                else { throw std::invalid_argument("FEN has unknown castling rights"); }
+            }
+        }
+
+        // En passant square is behind the pawn that has just moved two squares
+        if (!en_passant.empty() && en_passant != "-") {
+            int target_position{board_position_to_index(en_passant)};
+            int pawn_position{target_position/8 == 2 ? target_position + 8 : target_position - 8};
+            pcs::chess_piece* pawn{target_position/8 == 2 || target_position/8 == 5 ? chess_board[pawn_position].get() : nullptr};
+            if (!pawn || pawn->get_symbol() != 'p' || pawn->get_piece_color() == side_to_move) {
+                throw std::invalid_argument("FEN en passant square has no pawn that can be captured");
+            }
+            pawn->set_en_passant_possibility(true);
+        }
+
+        return std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color>(std::move(chess_board), side_to_move);
+    }
+
+
+    std::uint64_t pawn_zobrist_key(pcs::color pawn_color, int position) {
+        // Keys are generated once from a fixed seed so pawn hashes are reproducible between runs
+        struct pawn_keys {
+            std::uint64_t keys[2][64];
+
+            pawn_keys() {
+                std::mt19937_64 engine{0x9a3bfeedULL};
+                for (int i{} ; i < 2 ; i++) {
+                    for (int j{} ; j < 64 ; j++) {
+                        keys[i][j] = engine();
+                    }
+                }
+            }
+        };
+        static const pawn_keys pawn_hash_keys;
+
+        return pawn_hash_keys.keys[pawn_color][position];
+    }
 }
 
 
 brd::board::board() {
     chess_board = initialize_board(std::move(chess_board));
+    initialize_evaluation();
 }
 
 
-brd::board::board(const brd::board &board_to_copy) {
+brd::board::board(const brd::board &board_to_copy) : middlegame_score{board_to_copy.middlegame_score},
+                                                     endgame_score{board_to_copy.endgame_score},
+                                                     game_phase{board_to_copy.game_phase},
+                                                     pawn_hash{board_to_copy.pawn_hash},
+                                                     piece_accumulator(board_to_copy.piece_accumulator) {
     // Perform deep copy of all chess piece pointers in chess board to copies 
     // chess board vector 
     for (size_t i{0} ; i < 8*8 ; i++) {
@@ -202,6 +340,7 @@ brd::board::board(std::vector<std::unique_ptr<pcs::chess_piece>> &board_to_copy)
             chess_board.push_back((*board_piece)->clone());
         }
     }
+    initialize_evaluation();
 }
 
 
@@ -210,6 +349,7 @@ void brd::board::reset() {
     chess_board.clear();
 
     chess_board = initialize_board(std::move(chess_board));
+    initialize_evaluation();
 }
 
 
@@ -226,30 +366,91 @@ std::vector<std::unique_ptr<pcs::chess_piece>> brd::board::get_board() const {
 }
 
 
+void brd::board::initialize_evaluation() {
+    // Full scan of the board, after this the evaluation is updated as pieces move
+    middlegame_score = 0;
+    endgame_score = 0;
+    game_phase = 0;
+    pawn_hash = 0;
+    piece_accumulator.network_version = -1;
+    for (int i{} ; i < 8*8 ; i++) {
+        if (chess_board[i]) {
+            add_piece_to_evaluation(i);
+        }
+    }
+}
+
+
+void brd::board::add_piece_to_evaluation(int position) {
+    pcs::chess_piece* piece{chess_board[position].get()};
+    int sign{piece->get_piece_color() == pcs::white ? 1 : -1};
+    middlegame_score += sign*evl::piece_square_value(piece->get_symbol(), piece->get_piece_color(), position, evl::middlegame);
+    endgame_score += sign*evl::piece_square_value(piece->get_symbol(), piece->get_piece_color(), position, evl::endgame);
+    game_phase += evl::piece_phase(piece->get_symbol());
+    if (piece->get_symbol() == 'p') {
+        pawn_hash ^= pawn_zobrist_key(piece->get_piece_color(), position);
+    }
+    if (piece_accumulator.network_version >= 0) {
+        nnue::update_accumulator(piece_accumulator, piece->get_symbol(), piece->get_piece_color(), position, true);
+    }
+}
+
+
+void brd::board::remove_piece_from_evaluation(int position) {
+    pcs::chess_piece* piece{chess_board[position].get()};
+    int sign{piece->get_piece_color() == pcs::white ? 1 : -1};
+    middlegame_score -= sign*evl::piece_square_value(piece->get_symbol(), piece->get_piece_color(), position, evl::middlegame);
+    endgame_score -= sign*evl::piece_square_value(piece->get_symbol(), piece->get_piece_color(), position, evl::endgame);
+    game_phase -= evl::piece_phase(piece->get_symbol());
+    if (piece->get_symbol() == 'p') {
+        pawn_hash ^= pawn_zobrist_key(piece->get_piece_color(), position);
+    }
+    if (piece_accumulator.network_version >= 0) {
+        nnue::update_accumulator(piece_accumulator, piece->get_symbol(), piece->get_piece_color(), position, false);
+    }
+}
+
+
+void brd::board::remove_piece(int position) {
+    if (chess_board[position]) {
+        remove_piece_from_evaluation(position);
+        chess_board[position].reset();
+    }
+}
+
+
+void brd::board::relocate_piece(int initial_position, int final_position) {
+    // Any piece on the final position is captured
+    remove_piece(final_position);
+    remove_piece_from_evaluation(initial_position);
+    chess_board[final_position] = std::move(chess_board[initial_position]);
+    add_piece_to_evaluation(final_position);
+}
+
+
 void brd::board::move_piece(int initial_position, int final_position, move_type move) {
     if (move == standard) {
-        chess_board[final_position] = std::move(chess_board[initial_position]);
+        relocate_piece(initial_position, final_position);
     } else if (move == en_passant) {
         // Piece which was captured en passant but not landed on, must be removed from board
-        // so first move piece to be captured back, then capture as normal
         if (final_position == initial_position + 8 + 1 || final_position == initial_position + 8 - 1) {
-            chess_board[final_position] = std::move(chess_board[final_position - 8]);
+            remove_piece(final_position - 8);
         } else if (final_position == initial_position - 8 + 1 || final_position == initial_position - 8 - 1) {
-            chess_board[final_position] = std::move(chess_board[final_position + 8]);
+            remove_piece(final_position + 8);
         } else {
             throw std::invalid_argument("Error: Invalid en passant capture");
         }
-        chess_board[final_position] = std::move(chess_board[initial_position]);
+        relocate_piece(initial_position, final_position);
         
     } else if (move == castling) {
         if (chess_board[initial_position]->get_symbol() == 'K' && final_position > initial_position) {
-            chess_board[final_position - 1] = std::move(chess_board[initial_position + 3]); // Move rook
+            relocate_piece(initial_position + 3, final_position - 1); // Move rook
         } else if (chess_board[initial_position]->get_symbol() == 'K' && final_position < initial_position) {
-            chess_board[final_position + 1] = std::move(chess_board[initial_position - 4]); // Move rook
+            relocate_piece(initial_position - 4, final_position + 1); // Move rook
         } else {
             throw std::invalid_argument("Error: Invalid castling move");
         }
-        chess_board[final_position] = std::move(chess_board[initial_position]); // Move king as normal
+        relocate_piece(initial_position, final_position); // Move king as normal
 
     } else {
         throw std::invalid_argument("Error: Invalid move type"); 
@@ -262,14 +463,134 @@ void brd::board::move_piece(int initial_position, int final_position) {
         (final_position == initial_position + 8 + 1 || final_position == initial_position + 8 - 1) ) {
 
         // En passant move upwards
-        chess_board[final_position] = std::move(chess_board[final_position - 8]);
+        remove_piece(final_position - 8);
     } else if (chess_board[initial_position]->get_symbol() == 'p' &&  
                 !chess_board[final_position] &&
                 (final_position == initial_position - 8 + 1 || final_position == initial_position - 8 - 1) ) {
                 
         // En passant move down
-        chess_board[final_position] = std::move(chess_board[final_position + 8]);
+        remove_piece(final_position + 8);
     }
-    chess_board[final_position] = std::move(chess_board[initial_position]);
+    relocate_piece(initial_position, final_position);
     chess_board[final_position]->has_been_moved();
-}
\ No newline at end of file
+}
+
+
+void brd::board::promote_pawn(int position, char promotion_symbol) {
+    pcs::color piece_color{chess_board[position]->get_piece_color()};
+    int old_pawn_id{chess_board[position]->get_id()};
+    bool has_moved{true};
+
+    remove_piece_from_evaluation(position);
+    if (promotion_symbol == 'N') {
+        chess_board[position] = std::make_unique<pcs::knight>(pcs::knight(piece_color, old_pawn_id, has_moved));
+    } else if (promotion_symbol == 'B') {
+        chess_board[position] = std::make_unique<pcs::bishop>(pcs::bishop(piece_color, old_pawn_id, has_moved));
+    } else if (promotion_symbol == 'R') {
+        chess_board[position] = std::make_unique<pcs::rook>(pcs::rook(piece_color, old_pawn_id, has_moved));
+    } else if (promotion_symbol == 'Q') {
+        chess_board[position] = std::make_unique<pcs::queen>(pcs::queen(piece_color, old_pawn_id, has_moved));
+    } else {
+        add_piece_to_evaluation(position);
+        throw std::invalid_argument("Error: Invalid promotion piece");
+    }
+    add_piece_to_evaluation(position);
+}
+
+
+int brd::board::get_evaluation() const {
+    // Score from white's point of view, blended between middlegame and endgame
+    return evl::tapered_score(middlegame_score, endgame_score, game_phase);
+}
+
+
+bool brd::board::is_square_attacked(int position, pcs::color attacking_color) const {
+    return find_attackers(position, attacking_color, 0, nullptr);
+}
+
+
+std::vector<int> brd::board::get_attackers(int position, pcs::color attacking_color, std::uint64_t ignored_squares) const {
+    std::vector<int> attackers{};
+    find_attackers(position, attacking_color, ignored_squares, &attackers);
+    return attackers;
+}
+
+
+bool brd::board::find_attackers(int position, pcs::color attacking_color, 
+                                std::uint64_t ignored_squares, std::vector<int>* attackers) const {
+    int position_row{position/8};
+    int position_col{position%8};
+    bool is_attacked{false};
+
+    // Squares in ignored_squares are treated as empty (e.g. pieces already exchanged off),
+    // so sliding pieces behind them are found as well
+    auto is_occupied = [this, ignored_squares](int index) -> bool {
+        return chess_board[index] && !((ignored_squares >> index) & 1);
+    };
+    // Records the square if it holds an attacking piece with one of the given symbols
+    auto attacker_on_square = [&](int row, int col, std::string symbols) -> bool {
+        if (row < 0 || row >= 8 || col < 0 || col >= 8 || !is_occupied(8*row + col)) {
+            return false;
+        }
+        const std::unique_ptr<pcs::chess_piece>& piece{chess_board[8*row + col]};
+        if (piece->get_piece_color() == attacking_color && symbols.find(piece->get_symbol()) != std::string::npos) {
+            is_attacked = true;
+            if (attackers) {
+                attackers->push_back(8*row + col);
+            }
+            return true;
+        }
+        return false;
+    };
+    // Only need to carry on looking if all attackers are wanted
+    auto can_stop = [&]() -> bool { return is_attacked && !attackers; };
+
+    // Pawns attack diagonally forwards, so look one row behind the square (from the attacker's side)
+    int pawn_row{attacking_color == pcs::white ? position_row - 1 : position_row + 1};
+    attacker_on_square(pawn_row, position_col - 1, "p");
+    attacker_on_square(pawn_row, position_col + 1, "p");
+    if (can_stop()) {
+        return true;
+    }
+
+    // Knights and kings only reach a fixed set of neighbouring squares
+    const int knight_steps[8][2]{{2, 1}, {2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}, {-2, 1}, {-2, -1}};
+    const int king_steps[8][2]{{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    for (int i{} ; i < 8 ; i++) {
+        attacker_on_square(position_row + knight_steps[i][0], position_col + knight_steps[i][1], "N");
+        attacker_on_square(position_row + king_steps[i][0], position_col + king_steps[i][1], "K");
+        if (can_stop()) {
+            return true;
+        }
+    }
+
+    // Sliding pieces attack along rays until the first occupied square
+    for (int i{} ; i < 8 ; i++) {
+        bool is_diagonal{king_steps[i][0] != 0 && king_steps[i][1] != 0};
+        std::string sliding_symbols{is_diagonal ? "BQ" : "RQ"};
+        int row{position_row + king_steps[i][0]};
+        int col{position_col + king_steps[i][1]};
+        while (row >= 0 && row < 8 && col >= 0 && col < 8) {
+            if (is_occupied(8*row + col)) {
+                attacker_on_square(row, col, sliding_symbols);
+                break;
+            }
+            row += king_steps[i][0];
+            col += king_steps[i][1];
+        }
+        if (can_stop()) {
+            return true;
+        }
+    }
+    return is_attacked;
+}
+
+
+int brd::board::find_king(pcs::color king_color) const {
+    for (int i{} ; i < 8*8 ; i++) {
+        if (chess_board[i] && chess_board[i]->get_symbol() == 'K' && chess_board[i]->get_piece_color() == king_color) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,998 @@
+// object-oriented-chess-game/chess_engine.cpp
+//
+// Source file for chess engine search
+// and move ordering
+//
+// Author: Jason Dominguez
+
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <ios>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "neural_network.hpp"
+#include "tablebase.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    int piece_type_index(char piece_symbol) {
+        switch (piece_symbol) {
+            case 'p': return 0;
+            case 'N': return 1;
+            case 'B': return 2;
+            case 'R': return 3;
+            case 'Q': return 4;
+            case 'K': return 5;
+            default:
+                throw std::invalid_argument("Invalid chess piece symbol");
+        }
+    }
+
+
+    int piece_value(char piece_symbol) {
+        const int values[6]{100, 320, 330, 500, 900, 0};
+        return values[piece_type_index(piece_symbol)];
+    }
+
+
+    std::uint64_t position_hash(const brd::board& chess_board, pcs::color side_to_move) {
+        // Zobrist keys are generated once from a fixed seed so hashes are reproducible between runs
+        struct zobrist_keys {
+            std::uint64_t pieces[2][6][64];
+            std::uint64_t unmoved[64];
+            std::uint64_t en_passant[64];
+            std::uint64_t black_to_move;
+
+            zobrist_keys() {
+                std::mt19937_64 engine{0x5eedc0ffeeULL};
+                for (int i{} ; i < 2 ; i++) {
+                    for (int j{} ; j < 6 ; j++) {
+                        for (int k{} ; k < 64 ; k++) {
+                            pieces[i][j][k] = engine();
+                        }
+                    }
+                }
+                for (int k{} ; k < 64 ; k++) {
+                    unmoved[k] = engine();
+                    en_passant[k] = engine();
+                }
+                black_to_move = engine();
+            }
+        };
+        static const zobrist_keys keys;
+
+        std::uint64_t hash{};
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (!piece) {
+                continue;
+            }
+            char symbol{piece->get_symbol()};
+            hash ^= keys.pieces[piece->get_piece_color()][piece_type_index(symbol)][i];
+            // Unmoved kings and rooks carry the castling rights, pawns the en passant rights
+            if ((symbol == 'K' || symbol == 'R') && !piece->get_has_moved()) {
+                hash ^= keys.unmoved[i];
+            } else if (symbol == 'p' && piece->is_en_passant_possible()) {
+                hash ^= keys.en_passant[i];
+            }
+        }
+        if (side_to_move == pcs::black) {
+            hash ^= keys.black_to_move;
+        }
+        return hash;
+    }
+
+
+    std::string move_to_string(const move& chosen_move) {
+        std::string move_string{brd::board_index_to_position(chosen_move.start_position) +
+                                brd::board_index_to_position(chosen_move.end_position)};
+        if (chosen_move.promotion_symbol) {
+            move_string += chosen_move.promotion_symbol;
+        }
+        return move_string;
+    }
+
+
+    std::string score_to_string(int score) {
+        std::stringstream score_output;
+        if (score > checkmate_score - max_mate_ply) {
+            score_output << "#" << (checkmate_score - score + 1)/2;
+        } else if (score < -checkmate_score + max_mate_ply) {
+            score_output << "#-" << (checkmate_score + score)/2;
+        } else {
+            score_output << std::showpos << std::fixed << std::setprecision(2) << score/100.0;
+        }
+        return score_output.str();
+    }
+
+
+    std::uint64_t hash_scheme_fingerprint() {
+        // Hashes of the starting position with each side to move use every kind of Zobrist key
+        brd::board starting_board{};
+        return position_hash(starting_board, pcs::white) * 31 + position_hash(starting_board, pcs::black);
+    }
+
+
+    brd::move_type get_move_type(const brd::board& chess_board, const move& chosen_move) {
+        pcs::chess_piece* piece{chess_board.get_piece(chosen_move.start_position)};
+        int move_distance{chosen_move.end_position - chosen_move.start_position};
+
+        // Pawn moving diagonally into an empty square must be en passant,
+        // king moving by two squares must be castling
+        if (piece->get_symbol() == 'p' && !chess_board.get_piece(chosen_move.end_position) && move_distance%8 != 0) {
+            return brd::en_passant;
+        } else if (piece->get_symbol() == 'K' && (move_distance == 2 || move_distance == -2)) {
+            return brd::castling;
+        }
+        return brd::standard;
+    }
+
+
+    bool is_capture(const brd::board& chess_board, const move& chosen_move) {
+        return chess_board.get_piece(chosen_move.end_position) || get_move_type(chess_board, chosen_move) == brd::en_passant;
+    }
+
+
+    bool is_in_check(const brd::board& chess_board, pcs::color king_color) {
+        int king_position{chess_board.find_king(king_color)};
+        return king_position >= 0 && chess_board.is_square_attacked(king_position, pcs::opposite_color(king_color));
+    }
+
+
+    void make_move(brd::board& chess_board, const move& chosen_move) {
+        int start_position_index{chosen_move.start_position};
+        int end_position_index{chosen_move.end_position};
+        brd::move_type type_of_move{get_move_type(chess_board, chosen_move)};
+
+        chess_board.move_piece(start_position_index, end_position_index, type_of_move);
+
+        // Same bookkeeping as a move made during a game: en passant rights only last one move
+        for (int i{} ; i < 8*8 ; i++) {
+            if (chess_board[i] && chess_board[i]->get_symbol() == 'p') {
+                chess_board[i]->set_en_passant_possibility(false);
+            }
+        }
+        std::unique_ptr<pcs::chess_piece>& moved_piece{chess_board[end_position_index]};
+        if (moved_piece->get_symbol() == 'p' && !moved_piece->get_has_moved() &&
+            (end_position_index - start_position_index == 16 || end_position_index - start_position_index == -16)) {
+
+            moved_piece->set_en_passant_possibility(true);
+        }
+        moved_piece->has_been_moved();
+
+        if (type_of_move == brd::castling) {
+            if (end_position_index > start_position_index) {
+                chess_board[end_position_index - 1]->has_been_moved();
+            } else {
+                chess_board[end_position_index + 1]->has_been_moved();
+            }
+        }
+
+        if (chosen_move.promotion_symbol) {
+            chess_board.promote_pawn(end_position_index, chosen_move.promotion_symbol);
+        }
+    }
+
+
+    std::vector<move> generate_legal_moves(const brd::board& chess_board, pcs::color side_to_move) {
+        return generate_legal_moves(chess_board, side_to_move, false);
+    }
+
+
+    std::vector<move> generate_legal_moves(const brd::board& chess_board, pcs::color side_to_move, bool captures_only) {
+        std::vector<move> legal_moves{};
+        pcs::color opposition_color{pcs::opposite_color(side_to_move)};
+        bool in_check{is_in_check(chess_board, side_to_move)};
+
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (!piece || piece->get_piece_color() != side_to_move) {
+                continue;
+            }
+            std::vector<int> possible_final_positions{piece->get_valid_moves(i, std::move(chess_board.get_board()))};
+
+            std::vector<int>::iterator first_position{possible_final_positions.begin()};
+            std::vector<int>::iterator last_position{possible_final_positions.end()};
+            std::vector<int>::iterator final_position;
+            for (final_position = first_position ; final_position < last_position ; ++final_position) {
+                move candidate_move{i, *final_position};
+                int final_row{*final_position/8};
+                bool is_promotion{piece->get_symbol() == 'p' && (final_row == 0 || final_row == 7)};
+
+                // Filter before the legality check, which needs a copy of the board
+                if (captures_only && !is_promotion && !is_capture(chess_board, candidate_move)) {
+                    continue;
+                }
+
+                // Castling is not allowed out of, or through, check
+                if (get_move_type(chess_board, candidate_move) == brd::castling) {
+                    int passed_position{(i + *final_position)/2};
+                    if (in_check || chess_board.is_square_attacked(passed_position, opposition_color)) {
+                        continue;
+                    }
+                }
+
+                // Make the move on a copy and make sure the king cannot then be attacked
+                brd::board board_after_move{chess_board};
+                make_move(board_after_move, candidate_move);
+                if (is_in_check(board_after_move, side_to_move)) {
+                    continue;
+                }
+
+                if (is_promotion && captures_only) {
+                    // Under-promotions are left to the full width search
+                    legal_moves.push_back(move{i, *final_position, 'Q'});
+                } else if (is_promotion) {
+                    const char promotion_symbols[4]{'Q', 'N', 'R', 'B'};
+                    for (char promotion_symbol : promotion_symbols) {
+                        legal_moves.push_back(move{i, *final_position, promotion_symbol});
+                    }
+                } else {
+                    legal_moves.push_back(candidate_move);
+                }
+            }
+        }
+        return legal_moves;
+    }
+
+
+    int static_exchange_evaluation(const brd::board& chess_board, const move& capture) {
+        // Value of pieces for exchanges, king is given a value that no capture can make up for
+        auto exchange_value = [](char piece_symbol) -> int {
+            return piece_symbol == 'K' ? 20000 : piece_value(piece_symbol);
+        };
+
+        int target_position{capture.end_position};
+        pcs::chess_piece* moving_piece{chess_board.get_piece(capture.start_position)};
+        pcs::chess_piece* captured_piece{chess_board.get_piece(target_position)};
+
+        // Squares of pieces that have taken part in the exchange, treated as empty when
+        // looking for the next attacker so pieces lined up behind them are found
+        std::uint64_t used_squares{std::uint64_t{1} << capture.start_position};
+        if (get_move_type(chess_board, capture) == brd::en_passant) {
+            int captured_pawn_position{target_position + (moving_piece->get_piece_color() == pcs::white ? -8 : 8)};
+            used_squares |= std::uint64_t{1} << captured_pawn_position;
+        }
+
+        // gains[i] is the material balance after i + 1 captures, from the view of the side making that capture
+        int gains[32]{};
+        int number_of_captures{};
+        gains[0] = captured_piece ? exchange_value(captured_piece->get_symbol()) : piece_value('p');
+        int value_on_target{capture.promotion_symbol ? piece_value(capture.promotion_symbol)
+                                                     : exchange_value(moving_piece->get_symbol())};
+        pcs::color side_to_capture{pcs::opposite_color(moving_piece->get_piece_color())};
+
+        while (number_of_captures < 31) {
+            std::vector<int> attackers{chess_board.get_attackers(target_position, side_to_capture, used_squares)};
+            if (attackers.size() == 0) {
+                break;
+            }
+            // Always recapture with the least valuable attacker
+            int attacker_position{attackers[0]};
+            for (size_t i{1} ; i < attackers.size() ; i++) {
+                if (exchange_value(chess_board.get_piece(attackers[i])->get_symbol()) <
+                    exchange_value(chess_board.get_piece(attacker_position)->get_symbol())) {
+                    attacker_position = attackers[i];
+                }
+            }
+
+            ++number_of_captures;
+            gains[number_of_captures] = value_on_target - gains[number_of_captures - 1];
+            // Neither side can gain by carrying on, so the result is already decided
+            if (std::max(-gains[number_of_captures - 1], gains[number_of_captures]) < 0) {
+                break;
+            }
+            used_squares |= std::uint64_t{1} << attacker_position;
+            value_on_target = exchange_value(chess_board.get_piece(attacker_position)->get_symbol());
+            side_to_capture = pcs::opposite_color(side_to_capture);
+        }
+
+        // Each side may stop capturing when continuing would lose material
+        while (number_of_captures > 0) {
+            gains[number_of_captures - 1] = -std::max(-gains[number_of_captures - 1], gains[number_of_captures]);
+            --number_of_captures;
+        }
+        return gains[0];
+    }
+
+
+    bool has_non_pawn_material(const brd::board& chess_board, pcs::color piece_color) {
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (piece && piece->get_piece_color() == piece_color && piece->get_symbol() != 'p' && piece->get_symbol() != 'K') {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    int evaluate(const brd::board& chess_board, pcs::color side_to_move) {
+        evl::pawn_structure_score pawn_score{evl::evaluate_pawn_structure(chess_board)};
+        int score{evl::tapered_score(chess_board.get_middlegame_score() + pawn_score.middlegame,
+                                     chess_board.get_endgame_score() + pawn_score.endgame,
+                                     chess_board.get_game_phase())};
+        return side_to_move == pcs::white ? score : -score;
+    }
+
+
+    int evaluate(const brd::board& chess_board, pcs::color side_to_move, evl::pawn_hash_table& pawn_table) {
+        // Board keeps its piece-square scores up to date and pawn structure almost always
+        // comes from the pawn hash table, so this doesn't need a scan of the board
+        evl::pawn_structure_score pawn_score{pawn_table.get_score(chess_board)};
+        int score{evl::tapered_score(chess_board.get_middlegame_score() + pawn_score.middlegame,
+                                     chess_board.get_endgame_score() + pawn_score.endgame,
+                                     chess_board.get_game_phase())};
+        return side_to_move == pcs::white ? score : -score;
+    }
+
+
+    // Mate scores are stored relative to the node rather than the root, so they
+    // stay correct when the same position is reached at a different ply
+    int score_to_table(int score, int ply) {
+        if (score > checkmate_score - max_mate_ply) { return score + ply; }
+        if (score < -checkmate_score + max_mate_ply) { return score - ply; }
+        return score;
+    }
+
+
+    int score_from_table(int score, int ply) {
+        if (score > checkmate_score - max_mate_ply) { return score - ply; }
+        if (score < -checkmate_score + max_mate_ply) { return score + ply; }
+        return score;
+    }
+}
+
+
+// Saved tables are the raw entries, so they have to be plain data
+static_assert(std::is_trivially_copyable<eng::tt_entry>::value, "Transposition table entries must be trivially copyable");
+
+
+eng::transposition_table::transposition_table(size_t number_of_entries) {
+    resize(number_of_entries);
+}
+
+
+void eng::transposition_table::unmap() {
+    if (mapping) {
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+}
+
+
+bool eng::transposition_table::probe(std::uint64_t key, tt_entry& entry) const {
+    const tt_entry& stored_entry{entries[key%number_of_entries]};
+    if (stored_entry.depth >= 0 && stored_entry.key == key) {
+        entry = stored_entry;
+        return true;
+    }
+    return false;
+}
+
+
+void eng::transposition_table::store(const tt_entry& entry) {
+    // Depth-preferred replacement, but always replace entries from other positions
+    tt_entry& stored_entry{entries[entry.key%number_of_entries]};
+    if (stored_entry.key != entry.key || entry.depth >= stored_entry.depth) {
+        stored_entry = entry;
+    }
+}
+
+
+void eng::transposition_table::clear() {
+    if (mapping) {
+        // Clearing a mapped table would copy every page, a fresh table is the same thing
+        resize(number_of_entries);
+        return;
+    }
+    std::fill(owned_entries.begin(), owned_entries.end(), tt_entry{});
+}
+
+
+void eng::transposition_table::resize(size_t number_of_entries) {
+    if (number_of_entries == 0) {
+        throw std::invalid_argument("Transposition table must have at least one entry");
+    }
+    // Entries are placed by key modulo the size, so existing entries can't be kept
+    unmap();
+    owned_entries.assign(number_of_entries, tt_entry{});
+    entries = owned_entries.data();
+    this->number_of_entries = number_of_entries;
+}
+
+
+void eng::transposition_table::save(std::string file_name) const {
+    tt_file_header header{};
+    std::memcpy(header.magic, "OOCGHASH", sizeof(header.magic));
+    header.version = transposition_table_file_version;
+    header.entry_size = sizeof(tt_entry);
+    header.hash_scheme = hash_scheme_fingerprint();
+    header.number_of_entries = number_of_entries;
+
+    // Written to a temporary file first, so a failed save never leaves a truncated table behind
+    std::string temporary_file_name{file_name + ".tmp"};
+    std::ofstream table_file{temporary_file_name, std::ios::binary | std::ios::trunc};
+    if (!table_file) {
+        throw std::ios_base::failure("Transposition table file could not be created");
+    }
+    table_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    table_file.write(reinterpret_cast<const char*>(entries), number_of_entries*sizeof(tt_entry));
+    table_file.close();
+    if (!table_file || std::rename(temporary_file_name.c_str(), file_name.c_str()) != 0) {
+        std::remove(temporary_file_name.c_str());
+        throw std::ios_base::failure("Transposition table could not be saved");
+    }
+}
+
+
+void eng::transposition_table::load(std::string file_name) {
+    int file_descriptor{::open(file_name.c_str(), O_RDONLY)};
+    if (file_descriptor < 0) {
+        throw std::ios_base::failure("Transposition table file could not be opened");
+    }
+    struct stat file_status;
+    if (fstat(file_descriptor, &file_status) != 0 || static_cast<size_t>(file_status.st_size) < sizeof(tt_file_header)) {
+        ::close(file_descriptor);
+        throw std::ios_base::failure("Transposition table file is not valid");
+    }
+
+    // Private mapping: the search writes to its own copy of a page, the file itself is never changed
+    size_t file_size{static_cast<size_t>(file_status.st_size)};
+    void* file_mapping{mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file_descriptor, 0)};
+    ::close(file_descriptor);
+    if (file_mapping == MAP_FAILED) {
+        throw std::ios_base::failure("Transposition table file could not be memory-mapped");
+    }
+
+    tt_file_header header{};
+    std::memcpy(&header, file_mapping, sizeof(header));
+    std::string error_message{};
+    if (std::memcmp(header.magic, "OOCGHASH", sizeof(header.magic)) != 0) {
+        error_message = "Transposition table file is not valid";
+    } else if (header.version != transposition_table_file_version || header.entry_size != sizeof(tt_entry)) {
+        error_message = "Transposition table file has an unsupported format version";
+    } else if (header.hash_scheme != hash_scheme_fingerprint()) {
+        error_message = "Transposition table file was saved with a different hash scheme";
+    } else if (header.number_of_entries == 0 ||
+               file_size != sizeof(tt_file_header) + header.number_of_entries*sizeof(tt_entry)) {
+        error_message = "Transposition table file is the wrong size";
+    }
+    if (!error_message.empty()) {
+        munmap(file_mapping, file_size);
+        throw std::ios_base::failure(error_message);
+    }
+    // Probes go to one entry picked by the key, so read ahead would only load pages that aren't needed
+    madvise(file_mapping, file_size, MADV_RANDOM);
+
+    unmap();
+    owned_entries = std::vector<tt_entry>{};
+    mapping = file_mapping;
+    mapping_size = file_size;
+    entries = reinterpret_cast<tt_entry*>(static_cast<char*>(file_mapping) + sizeof(tt_file_header));
+    number_of_entries = header.number_of_entries;
+}
+
+
+eng::search::search() : table(1 << 16), pawn_table(1 << 14) {
+    std::fill(&history[0][0][0], &history[0][0][0] + 2*64*64, 0);
+}
+
+
+eng::search::search(const search_options& search_settings) : table(1 << 16), pawn_table(1 << 14), options{search_settings} {
+    std::fill(&history[0][0][0], &history[0][0][0] + 2*64*64, 0);
+}
+
+
+int eng::search::static_evaluation(const brd::board& chess_board, pcs::color side_to_move) {
+    if (options.use_neural_network && nnue::is_network_loaded()) {
+        return nnue::evaluate(chess_board, side_to_move);
+    }
+    return evaluate(chess_board, side_to_move, pawn_table);
+}
+
+
+std::vector<int> eng::search::score_moves(const brd::board& chess_board, pcs::color side_to_move,
+                                          const std::vector<move>& moves, const move& hash_move, int ply) {
+    // Order: hash move, then captures by most valuable victim / least valuable attacker,
+    // then killer moves and finally quiet moves by their history score
+    const int hash_move_score{4000000};
+    const int capture_score{3000000};
+    const int first_killer_score{2000000};
+    const int second_killer_score{1900000};
+
+    std::vector<int> move_scores{};
+    std::vector<move>::const_iterator first_move{moves.begin()};
+    std::vector<move>::const_iterator last_move{moves.end()};
+    std::vector<move>::const_iterator possible_move;
+    for (possible_move = first_move ; possible_move < last_move ; ++possible_move) {
+        int score{};
+        if (*possible_move == hash_move) {
+            score = hash_move_score;
+        } else if (is_capture(chess_board, *possible_move) || possible_move->promotion_symbol) {
+            pcs::chess_piece* victim{chess_board.get_piece(possible_move->end_position)};
+            int victim_value{victim ? piece_value(victim->get_symbol()) : piece_value('p')};
+            if (possible_move->promotion_symbol) {
+                victim_value += piece_value(possible_move->promotion_symbol);
+            }
+            int attacker_type{piece_type_index(chess_board.get_piece(possible_move->start_position)->get_symbol())};
+            score = capture_score + 10*victim_value - attacker_type;
+        } else if (*possible_move == killer_moves[ply][0]) {
+            score = first_killer_score;
+        } else if (*possible_move == killer_moves[ply][1]) {
+            score = second_killer_score;
+        } else {
+            score = history[side_to_move][possible_move->start_position][possible_move->end_position];
+        }
+        move_scores.push_back(score);
+    }
+    return move_scores;
+}
+
+
+void eng::search::update_quiet_move_tables(const move& cutoff_move, pcs::color side_to_move, int depth, int ply) {
+    if (killer_moves[ply][0] != cutoff_move) {
+        killer_moves[ply][1] = killer_moves[ply][0];
+        killer_moves[ply][0] = cutoff_move;
+    }
+
+    int& history_score{history[side_to_move][cutoff_move.start_position][cutoff_move.end_position]};
+    history_score += depth*depth;
+    // Keep history scores below the killer move scores by aging the whole table
+    if (history_score > 1000000) {
+        for (int i{} ; i < 2*64*64 ; i++) {
+            (&history[0][0][0])[i] /= 2;
+        }
+    }
+}
+
+
+int eng::search::negamax(const brd::board& chess_board, pcs::color side_to_move, int depth, int alpha, int beta, int ply,
+                         bool null_move_allowed) {
+    ++nodes_searched;
+    check_limits();
+    if (is_stopped()) {
+        return 0;
+    }
+
+    // Endgames covered by the tablebases have an exact result, so there's nothing to search
+    if (ply > 0 && egtb::are_tablebases_loaded() && egtb::get_number_of_pieces(chess_board) <= egtb::max_tablebase_pieces) {
+        egtb::probe_result tablebase_result{egtb::probe(chess_board, side_to_move)};
+        if (tablebase_result.found) {
+            if (tablebase_result.is_draw) {
+                return 0;
+            }
+            int mate_score{checkmate_score - ply - tablebase_result.plies_to_mate};
+            return tablebase_result.side_to_move_wins ? mate_score : -mate_score;
+        }
+    }
+
+    if (depth <= 0) {
+        return quiescence(chess_board, side_to_move, alpha, beta, ply);
+    }
+    if (ply >= max_search_ply - 1) {
+        return static_evaluation(chess_board, side_to_move);
+    }
+
+    // Use the transposition table for a cutoff or, failing that, the best move to try first
+    std::uint64_t key{position_hash(chess_board, side_to_move)};
+    int original_alpha{alpha};
+    move hash_move{};
+    tt_entry entry{};
+    if (table.probe(key, entry)) {
+        hash_move = entry.best_move;
+        int stored_score{score_from_table(entry.score, ply)};
+        if (ply > 0 && entry.depth >= depth) {
+            if (entry.bound == exact_bound ||
+                (entry.bound == lower_bound && stored_score >= beta) ||
+                (entry.bound == upper_bound && stored_score <= alpha)) {
+
+                return stored_score;
+            }
+        }
+    }
+
+    pcs::color opposition_color{pcs::opposite_color(side_to_move)};
+    bool in_check{is_in_check(chess_board, side_to_move)};
+    bool is_mate_window{beta > checkmate_score - max_mate_ply || alpha < -checkmate_score + max_mate_ply};
+    int static_score{};
+    if (!in_check) {
+        static_score = static_evaluation(chess_board, side_to_move);
+    }
+
+    // Null move pruning: if passing the turn still leaves us above beta after a reduced search,
+    // a real move would almost certainly do so too. Not used with only pawns left, where
+    // zugzwang makes passing better than any real move
+    if (options.use_null_move_pruning && null_move_allowed && ply > 0 && depth >= 3 && !in_check &&
+        !is_mate_window && static_score >= beta && has_non_pawn_material(chess_board, side_to_move)) {
+
+        int reduction{depth > 6 ? 3 : 2};
+        int null_move_score{-negamax(chess_board, opposition_color, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false)};
+        if (null_move_score >= beta) {
+            return beta;
+        }
+    }
+
+    std::vector<move> moves{generate_legal_moves(chess_board, side_to_move)};
+    if (moves.size() == 0) {
+        // Checkmate or stalemate
+        return in_check ? -checkmate_score + ply : 0;
+    }
+    std::vector<int> move_scores{score_moves(chess_board, side_to_move, moves, hash_move, ply)};
+
+    // Futility pruning: close to the leaves, quiet moves can't raise a hopeless static score above alpha
+    const int futility_margins[3]{0, 200, 500};
+    bool futility_pruning_possible{options.use_futility_pruning && ply > 0 && depth <= 2 && !in_check && !is_mate_window &&
+                                   static_score + futility_margins[depth] <= alpha};
+
+    move best_move{};
+    int best_score{-infinite_score};
+    for (size_t i{} ; i < moves.size() ; i++) {
+        // Bring the highest scored of the remaining moves forward, most nodes cut off
+        // after the first few moves so fully sorting the list would be wasted work
+        size_t best_index{i};
+        for (size_t j{i + 1} ; j < moves.size() ; j++) {
+            if (move_scores[j] > move_scores[best_index]) {
+                best_index = j;
+            }
+        }
+        std::swap(moves[i], moves[best_index]);
+        std::swap(move_scores[i], move_scores[best_index]);
+
+        // Multi-PV searches leave out the root moves of lines that have already been found
+        if (ply == 0 && std::find(excluded_root_moves.begin(), excluded_root_moves.end(), moves[i]) != excluded_root_moves.end()) {
+            continue;
+        }
+
+        bool is_quiet_move{!is_capture(chess_board, moves[i]) && !moves[i].promotion_symbol};
+        bool is_killer_move{moves[i] == killer_moves[ply][0] || moves[i] == killer_moves[ply][1]};
+
+        brd::board board_after_move{chess_board};
+        make_move(board_after_move, moves[i]);
+        bool gives_check{is_in_check(board_after_move, opposition_color)};
+
+        if (futility_pruning_possible && is_quiet_move && !gives_check && best_score > -infinite_score) {
+            best_score = std::max(best_score, static_score + futility_margins[depth]);
+            continue;
+        }
+
+        int score{};
+        // Late move reductions: quiet moves ordered late rarely turn out best, so first search
+        // them less deeply and only re-search at full depth if they beat alpha
+        if (options.use_late_move_reductions && i >= 3 && depth >= 3 && is_quiet_move && !is_killer_move &&
+            !in_check && !gives_check) {
+
+            int reduction{i >= 8 ? 2 : 1};
+            score = -negamax(board_after_move, opposition_color, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, true);
+            if (score > alpha) {
+                score = -negamax(board_after_move, opposition_color, depth - 1, -beta, -alpha, ply + 1, true);
+            }
+        } else {
+            score = -negamax(board_after_move, opposition_color, depth - 1, -beta, -alpha, ply + 1, true);
+        }
+
+        if (score > best_score) {
+            best_score = score;
+            best_move = moves[i];
+            if (ply == 0) {
+                root_best_move = best_move;
+            }
+        }
+        if (score > alpha) {
+            alpha = score;
+        }
+        if (alpha >= beta) {
+            if (is_quiet_move) {
+                update_quiet_move_tables(moves[i], side_to_move, depth, ply);
+            }
+            break;
+        }
+    }
+
+    bound_type bound{exact_bound};
+    if (best_score <= original_alpha) {
+        bound = upper_bound;
+    } else if (best_score >= beta) {
+        bound = lower_bound;
+    }
+    if (is_stopped()) {
+        // Scores from an abandoned search mustn't be kept for later searches
+        return 0;
+    }
+    if (ply == 0 && !excluded_root_moves.empty()) {
+        // Best of the remaining moves isn't the root position's real score
+        return best_score;
+    }
+    table.store(tt_entry{key, best_move, score_to_table(best_score, ply), depth, bound});
+
+    return best_score;
+}
+
+
+int eng::search::quiescence(const brd::board& chess_board, pcs::color side_to_move, int alpha, int beta, int ply) {
+    ++nodes_searched;
+    check_limits();
+    if (is_stopped()) {
+        return 0;
+    }
+
+    if (ply >= max_search_ply - 1) {
+        return static_evaluation(chess_board, side_to_move);
+    }
+
+    // When in check every evasion has to be searched, otherwise the side to move
+    // can "stand pat" and decline to capture anything
+    bool in_check{is_in_check(chess_board, side_to_move)};
+    int best_score{-infinite_score};
+    if (!in_check) {
+        best_score = static_evaluation(chess_board, side_to_move);
+        if (best_score >= beta) {
+            return best_score;
+        }
+        if (best_score > alpha) {
+            alpha = best_score;
+        }
+    }
+
+    std::vector<move> moves{generate_legal_moves(chess_board, side_to_move, !in_check)};
+    if (in_check && moves.size() == 0) {
+        return -checkmate_score + ply;
+    }
+    std::vector<int> move_scores{score_moves(chess_board, side_to_move, moves, move{}, ply)};
+
+    for (size_t i{} ; i < moves.size() ; i++) {
+        size_t best_index{i};
+        for (size_t j{i + 1} ; j < moves.size() ; j++) {
+            if (move_scores[j] > move_scores[best_index]) {
+                best_index = j;
+            }
+        }
+        std::swap(moves[i], moves[best_index]);
+        std::swap(move_scores[i], move_scores[best_index]);
+
+        // Skip captures that lose material once all the recaptures are played out
+        if (!in_check && !moves[i].promotion_symbol && static_exchange_evaluation(chess_board, moves[i]) < 0) {
+            continue;
+        }
+
+        brd::board board_after_move{chess_board};
+        make_move(board_after_move, moves[i]);
+        int score{-quiescence(board_after_move, pcs::opposite_color(side_to_move), -beta, -alpha, ply + 1)};
+
+        if (score > best_score) {
+            best_score = score;
+        }
+        if (score > alpha) {
+            alpha = score;
+        }
+        if (alpha >= beta) {
+            break;
+        }
+    }
+    return best_score;
+}
+
+
+void eng::search::start_new_search() {
+    // Transposition table entries stay valid between searches. History scores are halved
+    // so the last position's move ordering still helps without outweighing this one's,
+    // while killer moves depend on the ply and so are only useful within one search
+    for (int i{} ; i < 2*64*64 ; i++) {
+        (&history[0][0][0])[i] /= 2;
+    }
+    std::fill(&killer_moves[0][0], &killer_moves[0][0] + max_search_ply*2, move{});
+    root_best_move = move{};
+    excluded_root_moves.clear();
+    nodes_searched = 0;
+    limit_reached = false;
+    has_completed_iteration = false;
+    search_start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock{result_mutex};
+        completed_result = std::pair<move, int>{};
+        completed_depth = 0;
+    }
+}
+
+
+void eng::search::check_limits() {
+    if (!has_completed_iteration || limit_reached) {
+        return;
+    }
+    if (limits.max_nodes > 0 && nodes_searched >= limits.max_nodes) {
+        limit_reached = true;
+    }
+    // Reading the clock at every node would cost more than the nodes themselves
+    if (limits.max_time_ms > 0 && nodes_searched%1024 == 0 &&
+        std::chrono::steady_clock::now() - search_start >= std::chrono::milliseconds(limits.max_time_ms)) {
+        limit_reached = true;
+    }
+}
+
+
+std::pair<eng::move, int> eng::search::find_best_move(const brd::board& chess_board, pcs::color side_to_move, int max_depth) {
+    start_new_search();
+
+    // Iterative deepening, each iteration fills the tables used to order the next one
+    move best_move{};
+    int best_score{};
+    for (int depth{1} ; depth <= max_depth ; depth++) {
+        int score{negamax(chess_board, side_to_move, depth, -infinite_score, infinite_score, 0, false)};
+        if (is_stopped()) {
+            // Stopped part way through, so this iteration's result can't be trusted
+            break;
+        }
+        best_move = root_best_move;
+        best_score = score;
+        {
+            std::lock_guard<std::mutex> lock{result_mutex};
+            completed_result = std::pair<move, int>(best_move, best_score);
+            completed_depth = depth;
+        }
+        has_completed_iteration = true;
+        if (best_score > checkmate_score - max_mate_ply || best_score < -checkmate_score + max_mate_ply) {
+            // Forced mate found, deeper search can't improve on it
+            break;
+        }
+    }
+    return std::pair<move, int>(best_move, best_score);
+}
+
+
+std::vector<eng::analysed_line> eng::search::find_best_lines(const brd::board& chess_board, pcs::color side_to_move,
+                                                             int max_depth, int number_of_lines) {
+    start_new_search();
+    size_t number_of_legal_moves{generate_legal_moves(chess_board, side_to_move).size()};
+    size_t lines_wanted{std::min(static_cast<size_t>(std::max(1, number_of_lines)), number_of_legal_moves)};
+
+    // Each depth searches the best line, then the best line without its root move and so on. The searches
+    // share the transposition table, so the later ones cost far less than separate searches would
+    std::vector<analysed_line> best_lines;
+    for (int depth{1} ; depth <= max_depth ; depth++) {
+        std::vector<analysed_line> lines_at_depth;
+        for (size_t i{} ; i < lines_wanted ; i++) {
+            root_best_move = move{};
+            int score{negamax(chess_board, side_to_move, depth, -infinite_score, infinite_score, 0, false)};
+            if (is_stopped() || !root_best_move.is_valid()) {
+                break;
+            }
+            analysed_line line{};
+            line.score = score;
+            line.depth = depth;
+            line.principal_variation = get_principal_variation(chess_board, side_to_move, root_best_move, depth);
+            lines_at_depth.push_back(line);
+            excluded_root_moves.push_back(root_best_move);
+        }
+        excluded_root_moves.clear();
+        if (is_stopped()) {
+            // Stopped part way through, so keep the lines from the last completed depth
+            break;
+        }
+
+        // Later lines can occasionally score above earlier ones once they are searched on their own
+        std::stable_sort(lines_at_depth.begin(), lines_at_depth.end(), [](const analysed_line& first, const analysed_line& second) {
+            return first.score > second.score;
+        });
+        best_lines = lines_at_depth;
+        if (!best_lines.empty()) {
+            std::lock_guard<std::mutex> lock{result_mutex};
+            completed_result = std::pair<move, int>(best_lines.front().principal_variation.front(), best_lines.front().score);
+            completed_depth = depth;
+        }
+        has_completed_iteration = true;
+    }
+    return best_lines;
+}
+
+
+int eng::search::quiet_evaluation(const brd::board& chess_board, pcs::color side_to_move) {
+    return quiescence(chess_board, side_to_move, -infinite_score, infinite_score, 0);
+}
+
+
+std::vector<eng::move> eng::search::get_principal_variation(const brd::board& chess_board, pcs::color side_to_move,
+                                                            const move& first_move, int max_length) const {
+    // Expected continuation is read from the best moves stored in the transposition table
+    std::vector<move> principal_variation{first_move};
+    brd::board current_board{chess_board};
+    make_move(current_board, first_move);
+    pcs::color current_side{pcs::opposite_color(side_to_move)};
+    while (static_cast<int>(principal_variation.size()) < max_length) {
+        move hash_move{get_hash_move(current_board, current_side)};
+        if (!hash_move.is_valid()) {
+            break;
+        }
+        // A key collision could give a move from a different position, so the move has to be legal
+        std::vector<move> legal_moves{generate_legal_moves(current_board, current_side)};
+        if (std::find(legal_moves.begin(), legal_moves.end(), hash_move) == legal_moves.end()) {
+            break;
+        }
+        principal_variation.push_back(hash_move);
+        make_move(current_board, hash_move);
+        current_side = pcs::opposite_color(current_side);
+    }
+    return principal_variation;
+}
+
+
+void eng::search::clear() {
+    // Forget everything learnt from earlier searches, e.g. before a new game
+    table.clear();
+    pawn_table.clear();
+    std::fill(&history[0][0][0], &history[0][0][0] + 2*64*64, 0);
+    std::fill(&killer_moves[0][0], &killer_moves[0][0] + max_search_ply*2, move{});
+}
+
+
+void eng::search::resize_transposition_table(size_t number_of_entries) {
+    table.resize(number_of_entries);
+}
+
+
+int eng::search::get_completed_depth() const {
+    std::lock_guard<std::mutex> lock{result_mutex};
+    return completed_depth;
+}
+
+
+std::pair<eng::move, int> eng::search::get_completed_result() const {
+    std::lock_guard<std::mutex> lock{result_mutex};
+    return completed_result;
+}
+
+
+eng::move eng::search::get_hash_move(const brd::board& chess_board, pcs::color side_to_move) const {
+    // Best move stored for a position by the last search, e.g. the expected reply to the chosen move
+    tt_entry entry{};
+    if (table.probe(position_hash(chess_board, side_to_move), entry)) {
+        return entry.best_move;
+    }
+    return move{};
+}
+
+
+eng::background_analysis::background_analysis(const brd::board& chess_board, pcs::color side_to_move, int max_depth) :
+    analysis_board{chess_board} {
+
+    analysis_thread = std::thread([this, side_to_move, max_depth]() {
+        analysis_search.find_best_move(analysis_board, side_to_move, max_depth);
+        is_finished = true;
+    });
+}
+
+
+eng::background_analysis::~background_analysis() {
+    analysis_search.stop();
+    analysis_thread.join();
+}
+
+
+std::pair<eng::move, int> eng::background_analysis::get_best_move(int latency_ms) {
+    // Give the analysis until the deadline to finish, then use its last completed iteration
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(latency_ms);
+    while (!is_finished && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return analysis_search.get_completed_result();
+}
@@ -16,18 +16,25 @@
 #include <algorithm>
 #include <utility>
 #include <exception>
+#include <stdexcept>
 #include <ctime>
+#include <atomic>
 #include "player.hpp"
 #include "chess_pieces.hpp"
 #include "chess_board.hpp"
 #include "chess_game.hpp"
+#include "pgn_reader.hpp"
+#include "san.hpp"
+#include "game_archive.hpp"
+#include "chess_engine.hpp"
+#include "tablebase.hpp"
 
 
 // Class and function definitions
-int cgm::chess_game::games_played{0};
-int cgm::chess_game::player_one_wins{0};
-int cgm::chess_game::player_two_wins{0};
-int cgm::chess_game::draws{0};
+std::atomic<int> cgm::chess_game::games_played{0};
+std::atomic<int> cgm::chess_game::player_one_wins{0};
+std::atomic<int> cgm::chess_game::player_two_wins{0};
+std::atomic<int> cgm::chess_game::draws{0};
 
 
 void cgm::chess_game::get_next_player_ready() {
@@ -40,14 +47,15 @@ void cgm::chess_game::get_next_player_ready() {
 
 
 bool cgm::chess_game::current_player_make_a_move(bool in_check) {
-    std::pair<int, int> move{};
+    eng::move move{};
     try {
         move = current_player->choose_move(chess_board);
     } catch (bool quit_game) {
         return quit_game;
     }
-    int start_position_index = move.first;
-    int end_position_index = move.second;
+    int start_position_index = move.start_position;
+    int end_position_index = move.end_position;
+    chosen_promotion_symbol = move.promotion_symbol;
 
     brd::move_type type_of_move{brd::standard};
     // Must be en passant move if pawn is moving diagonally into empty square
@@ -161,7 +169,7 @@ void cgm::chess_game::promote_pawn_if_possible() {
     int opposite_row_begin_index;
     int opposite_row_end_index;
     if (current_player->get_piece_color() == pcs::white) {
-        opposite_row_begin_index = 57;
+        opposite_row_begin_index = 56;
         opposite_row_end_index = 64;
     } else {
         opposite_row_begin_index = 0;
@@ -174,7 +182,18 @@ void cgm::chess_game::promote_pawn_if_possible() {
             chess_board[i]->get_piece_color() == current_player->get_piece_color()) {
             
             int pawn_to_promote_index = i;
-            int old_pawn_id = chess_board[pawn_to_promote_index]->get_id();
+            // The bot's move says which piece it searched, and nobody is asked in a headless game or for
+            // a bot, which always takes a queen if its move doesn't say
+            if (chosen_promotion_symbol || is_headless || !current_player->get_is_human()) {
+                char promotion_symbol{chosen_promotion_symbol ? chosen_promotion_symbol : 'Q'};
+                chess_board.promote_pawn(pawn_to_promote_index, promotion_symbol);
+                moves_played.back() += "=";
+                moves_played.back() += promotion_symbol;
+                if (!is_headless) {
+                    std::cout << std::endl << this->get_chess_board() << std::endl;
+                }
+                break;
+            }
             std::cout << current_player->get_name() << ", you must promote your pawn, well done!" << std::endl;
 
             // Get user input for which piece to which they want to promote their pawn
@@ -183,30 +202,9 @@ void cgm::chess_game::promote_pawn_if_possible() {
                 std::string chosen_promotion_piece_symbol;
                 std::cin >> chosen_promotion_piece_symbol;
 
-                bool has_moved{true};
-                if (chosen_promotion_piece_symbol == "N") {
-                    chess_board[pawn_to_promote_index] = std::move(std::make_unique<pcs::knight>(pcs::knight(
-                                                                                                     current_player->get_piece_color(), 
-                                                                                                     old_pawn_id,
-                                                                                                     has_moved)));
-                    break;
-                } else if (chosen_promotion_piece_symbol == "B") {
-                    chess_board[pawn_to_promote_index] = std::move(std::make_unique<pcs::bishop>(pcs::bishop(
-                                                                                                     current_player->get_piece_color(),
-                                                                                                     old_pawn_id,
-                                                                                                     has_moved)));
-                    break;
-                } else if (chosen_promotion_piece_symbol == "R") {
-                    chess_board[pawn_to_promote_index] = std::move(std::make_unique<pcs::rook>(pcs::rook(
-                                                                                                   current_player->get_piece_color(),
-                                                                                                   old_pawn_id,
-                                                                                                   has_moved)));
-                    break;
-                } else if (chosen_promotion_piece_symbol == "Q") {
-                    chess_board[pawn_to_promote_index] = std::move(std::make_unique<pcs::queen>(pcs::queen(
-                                                                                                    current_player->get_piece_color(),
-                                                                                                    old_pawn_id,
-                                                                                                    has_moved)));
+                if (chosen_promotion_piece_symbol == "N" || chosen_promotion_piece_symbol == "B" ||
+                    chosen_promotion_piece_symbol == "R" || chosen_promotion_piece_symbol == "Q") {
+                    chess_board.promote_pawn(pawn_to_promote_index, chosen_promotion_piece_symbol[0]);
                     break;
                 } else {
                     std::cout << "You MUST promote to one of these pieces (N, B, R, Q)" << std::endl;
@@ -298,14 +296,18 @@ void cgm::chess_game::update_game_status() {
     }
     // Update the status of the game if check or checkmate has occurred
     if (check_on_opposition && !checkmate_on_opposition) {
-        std::cout << "Check!" << std::endl;
+        if (!is_headless) {
+            std::cout << "Check!" << std::endl;
+        }
         status = check;
         // Update record of moves if not a loaded in move
         if (moves_played.back().back() != '+') {
             moves_played.back() += "+";
         }
     } else if (checkmate_on_opposition) {
-        std::cout << "Checkmate!" << std::endl;
+        if (!is_headless) {
+            std::cout << "Checkmate!" << std::endl;
+        }
         status = checkmate;
         // Update record of moves if not a loaded in move
         if (moves_played.back().back() != '#') {
@@ -314,10 +316,38 @@ void cgm::chess_game::update_game_status() {
     } else {
         status = active;
     }
+
+    // Small endgames have a known result, so announce the distance to mate straight away
+    if (status != checkmate && !is_headless && egtb::are_tablebases_loaded() &&
+        egtb::get_number_of_pieces(chess_board) <= egtb::max_tablebase_pieces) {
+
+        pcs::color next_player_color{pcs::opposite_color(current_player->get_piece_color())};
+        egtb::probe_result tablebase_result{egtb::probe(chess_board, next_player_color)};
+        if (tablebase_result.found && tablebase_result.is_draw) {
+            std::cout << "Tablebase: this endgame is a draw" << std::endl;
+        } else if (tablebase_result.found) {
+            pcs::color winning_color{tablebase_result.side_to_move_wins ? next_player_color : current_player->get_piece_color()};
+            std::cout << "Tablebase: " << pcs::color_to_string(winning_color) << " mates in "
+                      << (tablebase_result.plies_to_mate + 1)/2 << " moves" << std::endl;
+        }
+    }
 }
 
 
 void cgm::chess_game::game_over() {
+    // Headless games only keep the score, an unfinished one counts as a draw
+    if (is_headless) {
+        ++games_played;
+        if (current_player == players[0] && status == checkmate) {
+            ++player_two_wins;
+        } else if (current_player == players[1] && status == checkmate) {
+            ++player_one_wins;
+        } else {
+            ++draws;
+            status = draw;
+        }
+        return;
+    }
     std::cout << "Game over!" << std::endl;
 
     ++games_played;
@@ -376,45 +406,61 @@ void cgm::chess_game::display_stats(std::string player_one_name, std::string pla
 
 
 void cgm::chess_game::save_game() {
-    std::cout << "Please enter a name for the saved file:" << std::endl;
+    std::cout << "Please enter a name for the saved file (ending it with " << game_archive_extension
+              << " saves in the compact binary format):" << std::endl;
     std::string file_name{};
     
     std::getline(std::cin, file_name, '\n');
 
-    std::ofstream save_file(file_name + ".pgn");
-
-    // Write heading of file in pgn format
-    save_file << "[Event \"Pointless chess game\"]" << std::endl;
-    save_file << "[Site \"Some computer somewhere\"]" << std::endl;
     std::time_t ttime;
     std::time(&ttime);
     std::tm date_and_time = *localtime(&ttime);
     int year{date_and_time.tm_year + 1900};
     int month{date_and_time.tm_mon};
     int day{date_and_time.tm_mday};
-    save_file << "[Date \"" << year << "." << month << "." << day << "\" ]" << std::endl; 
-    save_file << "[Round \"" << games_played << "\"]" << std::endl;
-
-    if (players[0]->get_piece_color() == pcs::white) {
-        save_file << "[White \"" << players[0]->get_name() << "\"]" << std::endl;
-        save_file << "[Black \"" << players[1]->get_name() << "\"]" << std::endl;
-    } else {
-        save_file << "[White \"" << players[1]->get_name() << "\"]" << std::endl;
-        save_file << "[Black \"" << players[0]->get_name() << "\"]" << std::endl;
+    std::string white_name{players[0]->get_piece_color() == pcs::white ? players[0]->get_name() : players[1]->get_name()};
+    std::string black_name{players[0]->get_piece_color() == pcs::white ? players[1]->get_name() : players[0]->get_name()};
+    std::string result{"*"};
+    if (status == checkmate) {
+        result = current_player->get_piece_color() != pcs::white ? "1-0" : "0-1";
+    } else if (status == draw) {
+        result = "1/2-1/2";
     }
 
-    if (status == checkmate) {
-        if (current_player->get_piece_color() != pcs::white) {
-            save_file << "[Result \"1-0\"]" << std::endl;
-        } else if (current_player->get_piece_color() != pcs::black) {
-            save_file << "[Result \"0-1\"]" << std::endl;
+    if (file_name.size() > game_archive_extension.size() &&
+        file_name.compare(file_name.size() - game_archive_extension.size(), game_archive_extension.size(), game_archive_extension) == 0) {
+        // The binary format keeps the moves as squares, found by replaying the notation from the start
+        pgn_game saved_game;
+        saved_game.tags = {{"Event", "Pointless chess game"}, {"Site", "Some computer somewhere"},
+                           {"Date", std::to_string(year) + "." + std::to_string(month) + "." + std::to_string(day)},
+                           {"Round", std::to_string(games_played)}, {"White", white_name}, {"Black", black_name},
+                           {"Result", result}};
+        saved_game.result = result;
+        std::vector<eng::move> saved_moves;
+        brd::board replay_board{};
+        pcs::color side_to_move{pcs::white};
+        for (auto move_iterator = moves_played.begin() ; move_iterator != moves_played.end() ; move_iterator++) {
+            saved_moves.push_back(resolve_san(replay_board, side_to_move, *move_iterator));
+            eng::make_move(replay_board, saved_moves.back());
+            side_to_move = pcs::opposite_color(side_to_move);
         }
-    } else if (status == draw) {
-        save_file << "[Result \"1/2-1/2\"]" << std::endl;
-    } else {
-        save_file << "[Result \"*\"]" << std::endl;
+        game_archive_writer writer{file_name};
+        writer.write(saved_game, saved_moves);
+        writer.close();
+        return;
     }
 
+    std::ofstream save_file(file_name + ".pgn");
+
+    // Write heading of file in pgn format
+    save_file << "[Event \"Pointless chess game\"]" << std::endl;
+    save_file << "[Site \"Some computer somewhere\"]" << std::endl;
+    save_file << "[Date \"" << year << "." << month << "." << day << "\" ]" << std::endl; 
+    save_file << "[Round \"" << games_played << "\"]" << std::endl;
+    save_file << "[White \"" << white_name << "\"]" << std::endl;
+    save_file << "[Black \"" << black_name << "\"]" << std::endl;
+    save_file << "[Result \"" << result << "\"]" << std::endl;
+
     // Write game's moves to file in pgn format
     std::vector<std::string>::iterator first_move{moves_played.begin()};
     std::vector<std::string>::iterator last_move{moves_played.end()};
@@ -432,14 +478,8 @@ void cgm::chess_game::save_game() {
     }
     
     // Write the final score (if game finished) file
-    if (status == checkmate) {
-        if (current_player->get_piece_color() != pcs::white) {
-            save_file << "1-0";
-        } else if (current_player->get_piece_color() != pcs::black) {
-            save_file << "0-1";
-        }
-    } else if (status == draw) {
-        save_file << "1/2-1/2";
+    if (result != "*") {
+        save_file << result;
     }
     save_file.close();
 }
@@ -447,138 +487,11 @@ void cgm::chess_game::save_game() {
 
 namespace cgm {
     std::vector<std::string> read_pgn(std::string file_name) {
-        std::string file_entry;
-        std::vector<std::string> loaded_moves;
-
-        std::ifstream pgn_file{file_name};
-        pgn_file.exceptions(std::ifstream::badbit);
-
-        if (pgn_file.fail()) {
-            throw std::ios_base::failure("File could not be opened");
-        }
-
-        // Read the moves made from the pgn file
-        while (!pgn_file.eof()) {
-            std::getline(pgn_file, file_entry);
-            if (file_entry.find("[") == 0) {
-                // Don't require the header lines
-                continue;
-            }
-            std::stringstream move_played;
-            move_played << file_entry;
-
-            // Extract moves player by white and black pieces
-            move_played.ignore(std::numeric_limits<std::streamsize>::max(),' ');
-            std::string white_move;
-            std::string black_move;
-            move_played >> white_move >> black_move;
-
-            // Add moves to their respective vectors
-            if (white_move != "" && white_move != "1-0" && white_move != "1/2-0" &&
-                white_move != "0-1/2" && white_move != "0-1") {
-                
-                loaded_moves.push_back(white_move);
-            }
-            if (black_move != "" && black_move != "1-0" && black_move != "1/2-0" &&
-                black_move != "0-1/2" && black_move != "0-1") {
-                
-                loaded_moves.push_back(black_move);
-            }
-        }
-        // Close the file
-        pgn_file.close();
-
-        return loaded_moves;
-    }
-
-
-    std::tuple<char, int, int, bool, char, brd::move_type> parse_pgn_move_notation(std::string loaded_move, pcs::color player_color) {
-        char piece_to_move_symbol{};
-        int start_position_index{-1};
-        int end_position_index{};
-        bool promotion_move{false};
-        char promotion_piece{};
-        brd::move_type type_of_move{brd::standard};
-        
-        // Remove check, capture or checkmate notation
-        // as it is not needed to recreate the move
-        if (loaded_move[loaded_move.length() - 1] == '+' || loaded_move[loaded_move.length() - 1] == '#') {
-            loaded_move.erase(loaded_move.begin() + loaded_move.length() - 1);
-        }
-        size_t x_pos{loaded_move.find('x')};
-        if (x_pos != std::string::npos) {
-            loaded_move.erase(loaded_move.begin() + x_pos);
-        }
-
-        if (loaded_move == "O-O"|| loaded_move == "0-0") {
-            // Move is kingside castling
-            type_of_move = brd::castling;
-            if (player_color == pcs::white) {
-                start_position_index = 4;
-                end_position_index = 6;
-            } else {
-                start_position_index = 60;
-                end_position_index = 62;
-            }
-        } else if (loaded_move == "O-O-O" || loaded_move == "0-0-0") {
-            // Move is queenside castling
-            type_of_move = brd::castling;
-            if (player_color == pcs::white) {
-                start_position_index = 4;
-                end_position_index = 2;
-            } else {
-                start_position_index = 60;
-                end_position_index = 58;
-            }
-        } else if (loaded_move.find_first_not_of("KQBNR") == 0) {
-            // Move is using a pawn, get end position (and start if given) and whether
-            // move is en passant or pawn get promoted
-            piece_to_move_symbol = 'p';
-
-            std::vector<char> piece_symbols{'K','Q','B','N','R'};
-            std::string en_passant_notation{"e.p."};
-            size_t en_passant_pos = loaded_move.find(en_passant_notation);
-            
-            if (en_passant_pos != std::string::npos) {
-                type_of_move = brd::en_passant;
-                // Remove en passant notation from move
-                loaded_move.erase(en_passant_pos, en_passant_notation.length());
-            } else if (std::any_of(std::begin(piece_symbols), std::end(piece_symbols), 
-                                       [&](const char& symbol) {
-                                           return loaded_move.find(symbol) != std::string::npos;
-                                       })) {
-                
-                // Loaded move contains other piece symbol (not at the beginning)
-                // therefore it a pawn promotion move
-                promotion_move = true;
-                // Remove promotion notation from move and get promotion piece symbol
-                promotion_piece = loaded_move[loaded_move.length() - 1];
-                loaded_move.erase(loaded_move.length() - 2, 2);
-            }
-            
-            if (loaded_move.length() == 2) {
-                end_position_index = brd::board_position_to_index(loaded_move);
-            } else if (loaded_move.length() == 4) {
-                start_position_index = brd::board_position_to_index(loaded_move.substr(0, 2));
-                end_position_index = brd::board_position_to_index(loaded_move.substr(2, 2));
-            } else {
-                throw std::invalid_argument("Error: Invalid portable game notation");
-            }
-        } else {
-            piece_to_move_symbol = loaded_move[0];
-            
-            if (loaded_move.length() == 3) {
-                end_position_index = brd::board_position_to_index(loaded_move.substr(1, 2));
-            } else if (loaded_move.length() == 5) {
-                start_position_index = brd::board_position_to_index(loaded_move.substr(1, 2));
-                end_position_index = brd::board_position_to_index(loaded_move.substr(3, 2));
-            } else {
-                throw std::invalid_argument("Error: Invalid portable game notation");
-            }
-        }
-
-        return std::make_tuple(piece_to_move_symbol, start_position_index, end_position_index,
-                               promotion_move, promotion_piece, type_of_move);
+        // Only the first game of the file is loaded
+        pgn_reader reader{file_name};
+        pgn_game loaded_game;
+        reader.read_game(loaded_game);
+        return loaded_game.moves;
     }
 }
 
@@ -587,13 +500,32 @@ void cgm::chess_game::load_game() {
     // Get the file to be loaded in, handling any exceptions for bad file names
     while (true) {
         try {
-            std::cout << "Please enter the name of the .pgn file you would like to load:" << std::endl;
+            std::cout << "Please enter the name of the .pgn file you would like to load, or of a "
+                      << game_archive_extension << " file with its extension:" << std::endl;
             std::string file_name{};
 
             std::getline(std::cin, file_name, '\n');
-    
+
+            bool is_archive{file_name.size() > game_archive_extension.size() &&
+                            file_name.compare(file_name.size() - game_archive_extension.size(), game_archive_extension.size(),
+                                              game_archive_extension) == 0};
             std::vector<std::string> loaded_moves;
-            loaded_moves = read_pgn(file_name + ".pgn");
+            std::vector<eng::move> archived_moves;
+            if (is_archive) {
+                // Only the first game of the file is loaded
+                game_archive_reader reader{file_name};
+                pgn_game loaded_game;
+                if (!reader.read_game(loaded_game, archived_moves)) {
+                    throw std::invalid_argument("Error: The file has no games in it");
+                }
+                if (!loaded_game.get_tag("FEN").empty()) {
+                    throw std::invalid_argument("Error: Only games from the starting position can be loaded");
+                }
+                // Every move is checked, and its notation made to record it, before the game is touched
+                loaded_moves = moves_to_san(loaded_game, archived_moves);
+            } else {
+                loaded_moves = read_pgn(file_name + ".pgn");
+            }
 
             std::cout << std::endl << "Loading game..." << std::endl << std::endl;
 
@@ -604,6 +536,17 @@ void cgm::chess_game::load_game() {
             // Ensure board is in initial setup before loading moves
             chess_board.reset();
 
+            if (is_archive) {
+                // Archived moves have been checked, so they are played straight onto the board
+                for (size_t i{} ; i < archived_moves.size() ; i++) {
+                    moves_played.push_back(loaded_moves[i]);
+                    eng::make_move(chess_board, archived_moves[i]);
+                    this->update_game_status();
+                    this->get_next_player_ready();
+                }
+                break;
+            }
+
             // Play the game with the loaded move to get game to the saved state
             // Get possible moves for player to check that loaded moves are valid
             std::vector<std::string>::iterator first_move{loaded_moves.begin()};
@@ -611,125 +554,13 @@ void cgm::chess_game::load_game() {
             std::vector<std::string>::iterator move;
             for (move = first_move ; move < last_move ; ++move) {
                 std::string loaded_move{*move};
-                std::string unedited_loaded_move{loaded_move}; // deep copy to be added to moves_played later
-
-                // Get move information from the pgn notation
-                std::tuple<char, int, int, 
-                           bool, char, brd::move_type> move_info = parse_pgn_move_notation(loaded_move, current_player->get_piece_color());
-
-                char piece_to_move_symbol{std::get<0>(move_info)};
-                int start_position_index{std::get<1>(move_info)};
-                int end_position_index{std::get<2>(move_info)};
-                bool promotion_move{std::get<3>(move_info)};
-                char promotion_piece{std::get<4>(move_info)};
-                brd::move_type type_of_move{std::get<5>(move_info)};
-
-                // Find whether move from file is valid
-                bool move_valid{false};
-                if (start_position_index == -1) {
-                    // Start position of move wasn't included in notation
-                    // Find start position of move
-                    std::vector<std::pair<int, std::vector<int>>> player_possible_moves{};
-                    brd::board copy_of_board{chess_board};
-                    player_possible_moves = current_player->get_player_piece_possible_moves(piece_to_move_symbol, 
-                                                                                            std::move(copy_of_board) );
-                    std::vector<std::pair<int, std::vector<int>>>::iterator first_possible_piece_and_moves{player_possible_moves.begin()};
-                    std::vector<std::pair<int, std::vector<int>>>::iterator last_possible_piece_and_moves{player_possible_moves.end()};
-                    std::vector<std::pair<int, std::vector<int>>>::iterator piece_and_moves;
-    
-                    for (piece_and_moves = first_possible_piece_and_moves ;
-                         piece_and_moves < last_possible_piece_and_moves ;
-                         ++piece_and_moves) {
-                        
-                        // Find whether loaded move is possible
-                        std::vector<int> possible_moves = piece_and_moves->second;
-                        if (std::find(possible_moves.begin(), possible_moves.end(), end_position_index) != possible_moves.end()) {
-                            move_valid = true;
-                            start_position_index = piece_and_moves->first;
-                            break;
-                        }
-                    }
-                } else {
-                    // Check that move is possible from start to end position
-                    if (!chess_board[start_position_index] || 
-                        chess_board[start_position_index]->get_piece_color() != this->current_player->get_piece_color()) {   
-                        
-                        throw std::invalid_argument("Error: Invalid chess move found");
-                    } else {
-                        std::vector<int> piece_valid_moves{};
-                        piece_valid_moves = chess_board[start_position_index]->get_valid_moves(start_position_index, 
-                                                                                               std::move(chess_board.get_board()));
-                        // Find whether loaded move is possible
-                        if (std::find(piece_valid_moves.begin(), piece_valid_moves.end(), end_position_index) != piece_valid_moves.end()) {
-                            move_valid = true;
-                        }
-                    }
-                }
-                if (!move_valid) {
-                    throw std::invalid_argument("Error: Invalid chess move found");
-                }
-    
-                // Record move
-                moves_played.push_back(unedited_loaded_move);
-
-                chess_board.move_piece(start_position_index, end_position_index, type_of_move);
 
-                // Reset all pawns to have no possibility of being captured via en passant
-                for (int i{} ; i < 8*8 ; i++) {
-                    if (chess_board[i] && chess_board[i]->get_symbol() == 'p') {
-                        chess_board[i]->set_en_passant_possibility(false);
-                    }
-                }
-                // If pawn was just moved by two and it was its first move, 
-                // it can be captured via en passant
-                if (chess_board[end_position_index]->get_symbol() == 'p' && chess_board[end_position_index]->get_has_moved() == false) {
-                    int pawn_position_row{end_position_index/8};
-                    int fourth_row_index{3};
-                    int fifth_row_index{4};
-                    if (chess_board[end_position_index]->get_piece_color() == pcs::white && pawn_position_row == fourth_row_index) {
-                        chess_board[end_position_index]->set_en_passant_possibility(true);
-                    } else if (chess_board[end_position_index]->get_piece_color() == pcs::black && pawn_position_row == fifth_row_index) {
-                        chess_board[end_position_index]->set_en_passant_possibility(true);
-                    }
-                }
-                // Setting has_been_moved must be after checking for en passant possibility as
-                // only pawns whose first move was two steps can be captured en passant, 
-                // so need to know if pawn had moved before this move
-                chess_board[end_position_index]->has_been_moved();
-                // For castling rook has also been moved
-                if (type_of_move == brd::castling) {
-                    if (end_position_index > start_position_index) {
-                        chess_board[end_position_index - 1]->has_been_moved();
-                    } else {
-                        chess_board[end_position_index + 1]->has_been_moved();
-                    }
-                }
+                // Throws if the move isn't legal here, or could be more than one move
+                eng::move resolved_move{resolve_san(chess_board, current_player->get_piece_color(), loaded_move)};
 
-                if (promotion_move) {
-                    // Promote pawn
-                    int old_pawn_id{chess_board[end_position_index]->get_id()};
-                    if (promotion_piece == 'N') {
-                        chess_board[end_position_index] = std::move(std::make_unique<pcs::knight>(pcs::knight(
-                                                                                                      current_player->get_piece_color(), 
-                                                                                                      old_pawn_id,
-                                                                                                      true) ));
-                    } else if (promotion_piece == 'B') {
-                        chess_board[end_position_index] = std::move(std::make_unique<pcs::bishop>(pcs::bishop(
-                                                                                                      current_player->get_piece_color(), 
-                                                                                                      old_pawn_id,
-                                                                                                      true) ));
-                    } else if (promotion_piece == 'R') {
-                        chess_board[end_position_index] = std::move(std::make_unique<pcs::rook>(pcs::rook(
-                                                                                                    current_player->get_piece_color(),
-                                                                                                    old_pawn_id,
-                                                                                                    true) ));
-                    } else if (promotion_piece == 'Q') {
-                        chess_board[end_position_index] = std::move(std::make_unique<pcs::queen>(pcs::queen(
-                                                                                                     current_player->get_piece_color(),
-                                                                                                     old_pawn_id,
-                                                                                                     true) ));
-                    }
-                } 
+                // Record move
+                moves_played.push_back(loaded_move);
+                eng::make_move(chess_board, resolved_move);
                 this->update_game_status();
                 this->get_next_player_ready();
             }
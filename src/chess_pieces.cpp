@@ -296,7 +296,9 @@ std::vector<int> pcs::pawn::get_valid_moves(int start_position, std::vector<std:
         }
     }
     // Check if diagonal moves are possible (if attacking opposite color piece or if en passant is possible)
-    if (start_position_row + position_increment < 8 && start_position_col + position_increment < 8) {
+    // Bounds are checked in both directions as black pawns move down the board (negative increment)
+    if (start_position_row + position_increment >= 0 && start_position_row + position_increment < 8 &&
+        start_position_col + position_increment >= 0 && start_position_col + position_increment < 8) {
         if ((chess_board[start_position + (8*position_increment + position_increment)] && 
              chess_board[start_position + (8*position_increment + position_increment)]->get_piece_color() != this->get_piece_color()) ||
             (chess_board[start_position + position_increment] && 
@@ -307,7 +309,8 @@ std::vector<int> pcs::pawn::get_valid_moves(int start_position, std::vector<std:
             valid_new_positions.push_back(start_position + (8*position_increment + position_increment)); // moving forward and right by 1
         }
     }
-    if (start_position_row + position_increment < 8 && start_position_col - position_increment >= 0) {
+    if (start_position_row + position_increment >= 0 && start_position_row + position_increment < 8 &&
+        start_position_col - position_increment >= 0 && start_position_col - position_increment < 8) {
         if ((chess_board[start_position + (8*position_increment - position_increment)] && 
              chess_board[start_position + (8*position_increment - position_increment)]->get_piece_color() != this->get_piece_color()) ||
             (chess_board[start_position - position_increment] && 
@@ -0,0 +1,52 @@
+// object-oriented-chess-game/engine_context.cpp
+//
+// Source file for the engine state a chess bot
+// keeps across moves and games
+//
+// Author: Jason Dominguez
+
+
+#include <cstddef>
+#include <string>
+#include <algorithm>
+#include "engine_context.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    size_t transposition_table_entries_for_megabytes(size_t megabytes) {
+        return std::max<size_t>(1, megabytes*1024*1024/sizeof(tt_entry));
+    }
+}
+
+
+eng::engine_context::engine_context() : engine_context(default_transposition_table_entries, 0) {}
+
+
+eng::engine_context::engine_context(size_t transposition_table_entries, size_t number_of_threads) :
+    worker_pool{thr::make_thread_pool(number_of_threads)}, tree_search(monte_carlo_options{}, *worker_pool) {
+
+    if (transposition_table_entries != default_transposition_table_entries) {
+        alpha_beta_search.resize_transposition_table(transposition_table_entries);
+    }
+}
+
+
+void eng::engine_context::clear() {
+    alpha_beta_search.clear();
+}
+
+
+void eng::engine_context::resize_transposition_table(size_t number_of_entries) {
+    alpha_beta_search.resize_transposition_table(number_of_entries);
+}
+
+
+void eng::engine_context::save_transposition_table(std::string file_name) const {
+    alpha_beta_search.save_transposition_table(file_name);
+}
+
+
+void eng::engine_context::load_transposition_table(std::string file_name) {
+    alpha_beta_search.load_transposition_table(file_name);
+}
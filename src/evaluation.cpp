@@ -0,0 +1,489 @@
+// object-oriented-chess-game/evaluation.cpp
+//
+// Source file for material and piece-square
+// table evaluation
+//
+// Author: Jason Dominguez
+
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <ios>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "evaluation.hpp"
+
+
+// Class and function definitions
+namespace evl {
+    // Material values for pawn, knight, bishop, rook, queen and king
+    const int material_values[2][6]{{82, 337, 365, 477, 1025, 0},
+                                    {94, 281, 297, 512, 936, 0}};
+
+    const int phase_values[6]{0, 1, 1, 2, 4, 0};
+
+    // Piece-square tables from white's point of view, laid out as seen
+    // from above the board (first row is the 8th rank)
+    const int pawn_table[2][64]{
+        {  0,   0,   0,   0,   0,   0,   0,   0,
+          50,  50,  50,  50,  50,  50,  50,  50,
+          10,  10,  20,  30,  30,  20,  10,  10,
+           5,   5,  10,  25,  25,  10,   5,   5,
+           0,   0,   0,  20,  20,   0,   0,   0,
+           5,  -5, -10,   0,   0, -10,  -5,   5,
+           5,  10,  10, -20, -20,  10,  10,   5,
+           0,   0,   0,   0,   0,   0,   0,   0},
+        {  0,   0,   0,   0,   0,   0,   0,   0,
+          80,  80,  80,  80,  80,  80,  80,  80,
+          50,  50,  50,  50,  50,  50,  50,  50,
+          30,  30,  30,  30,  30,  30,  30,  30,
+          20,  20,  20,  20,  20,  20,  20,  20,
+          10,  10,  10,  10,  10,  10,  10,  10,
+          10,  10,  10,  10,  10,  10,  10,  10,
+           0,   0,   0,   0,   0,   0,   0,   0}
+    };
+
+    const int knight_table[2][64]{
+        {-50, -40, -30, -30, -30, -30, -40, -50,
+         -40, -20,   0,   0,   0,   0, -20, -40,
+         -30,   0,  10,  15,  15,  10,   0, -30,
+         -30,   5,  15,  20,  20,  15,   5, -30,
+         -30,   0,  15,  20,  20,  15,   0, -30,
+         -30,   5,  10,  15,  15,  10,   5, -30,
+         -40, -20,   0,   5,   5,   0, -20, -40,
+         -50, -40, -30, -30, -30, -30, -40, -50},
+        {-50, -40, -30, -30, -30, -30, -40, -50,
+         -40, -20,   0,   0,   0,   0, -20, -40,
+         -30,   0,  10,  15,  15,  10,   0, -30,
+         -30,   5,  15,  20,  20,  15,   5, -30,
+         -30,   0,  15,  20,  20,  15,   0, -30,
+         -30,   5,  10,  15,  15,  10,   5, -30,
+         -40, -20,   0,   5,   5,   0, -20, -40,
+         -50, -40, -30, -30, -30, -30, -40, -50}
+    };
+
+    const int bishop_table[2][64]{
+        {-20, -10, -10, -10, -10, -10, -10, -20,
+         -10,   0,   0,   0,   0,   0,   0, -10,
+         -10,   0,   5,  10,  10,   5,   0, -10,
+         -10,   5,   5,  10,  10,   5,   5, -10,
+         -10,   0,  10,  10,  10,  10,   0, -10,
+         -10,  10,  10,  10,  10,  10,  10, -10,
+         -10,   5,   0,   0,   0,   0,   5, -10,
+         -20, -10, -10, -10, -10, -10, -10, -20},
+        {-20, -10, -10, -10, -10, -10, -10, -20,
+         -10,   0,   0,   0,   0,   0,   0, -10,
+         -10,   0,   5,  10,  10,   5,   0, -10,
+         -10,   5,   5,  10,  10,   5,   5, -10,
+         -10,   0,  10,  10,  10,  10,   0, -10,
+         -10,  10,  10,  10,  10,  10,  10, -10,
+         -10,   5,   0,   0,   0,   0,   5, -10,
+         -20, -10, -10, -10, -10, -10, -10, -20}
+    };
+
+    const int rook_table[2][64]{
+        {  0,   0,   0,   0,   0,   0,   0,   0,
+           5,  10,  10,  10,  10,  10,  10,   5,
+          -5,   0,   0,   0,   0,   0,   0,  -5,
+          -5,   0,   0,   0,   0,   0,   0,  -5,
+          -5,   0,   0,   0,   0,   0,   0,  -5,
+          -5,   0,   0,   0,   0,   0,   0,  -5,
+          -5,   0,   0,   0,   0,   0,   0,  -5,
+           0,   0,   0,   5,   5,   0,   0,   0},
+        {  0,   0,   0,   0,   0,   0,   0,   0,
+           5,   5,   5,   5,   5,   5,   5,   5,
+           0,   0,   0,   0,   0,   0,   0,   0,
+           0,   0,   0,   0,   0,   0,   0,   0,
+           0,   0,   0,   0,   0,   0,   0,   0,
+           0,   0,   0,   0,   0,   0,   0,   0,
+           0,   0,   0,   0,   0,   0,   0,   0,
+           0,   0,   0,   0,   0,   0,   0,   0}
+    };
+
+    const int queen_table[2][64]{
+        {-20, -10, -10,  -5,  -5, -10, -10, -20,
+         -10,   0,   0,   0,   0,   0,   0, -10,
+         -10,   0,   5,   5,   5,   5,   0, -10,
+          -5,   0,   5,   5,   5,   5,   0,  -5,
+           0,   0,   5,   5,   5,   5,   0,  -5,
+         -10,   5,   5,   5,   5,   5,   0, -10,
+         -10,   0,   5,   0,   0,   0,   0, -10,
+         -20, -10, -10,  -5,  -5, -10, -10, -20},
+        {-20, -10, -10,  -5,  -5, -10, -10, -20,
+         -10,   0,   0,   0,   0,   0,   0, -10,
+         -10,   0,   5,   5,   5,   5,   0, -10,
+          -5,   0,   5,   5,   5,   5,   0,  -5,
+          -5,   0,   5,   5,   5,   5,   0,  -5,
+         -10,   0,   5,   5,   5,   5,   0, -10,
+         -10,   0,   0,   0,   0,   0,   0, -10,
+         -20, -10, -10,  -5,  -5, -10, -10, -20}
+    };
+
+    // King should stay sheltered in the middlegame but become active in the endgame
+    const int king_table[2][64]{
+        {-30, -40, -40, -50, -50, -40, -40, -30,
+         -30, -40, -40, -50, -50, -40, -40, -30,
+         -30, -40, -40, -50, -50, -40, -40, -30,
+         -30, -40, -40, -50, -50, -40, -40, -30,
+         -20, -30, -30, -40, -40, -30, -30, -20,
+         -10, -20, -20, -20, -20, -20, -20, -10,
+          20,  20,   0,   0,   0,   0,  20,  20,
+          20,  30,  10,   0,   0,  10,  30,  20},
+        {-50, -40, -30, -20, -20, -30, -40, -50,
+         -30, -20, -10,   0,   0, -10, -20, -30,
+         -30, -10,  20,  30,  30,  20, -10, -30,
+         -30, -10,  30,  40,  40,  30, -10, -30,
+         -30, -10,  30,  40,  40,  30, -10, -30,
+         -30, -10,  20,  30,  30,  20, -10, -30,
+         -30, -30,   0,   0,   0,   0, -30, -30,
+         -50, -30, -30, -30, -30, -30, -30, -50}
+    };
+
+
+    // Pawn structure weights, passed pawn bonuses are indexed by rank from the pawn's own side
+    const int doubled_pawn_penalty[2]{10, 20};
+    const int isolated_pawn_penalty[2]{10, 15};
+    const int backward_pawn_penalty[2]{8, 10};
+    const int passed_pawn_bonus[2][8]{{0, 5, 10, 15, 25, 40, 60, 0},
+                                      {0, 10, 20, 35, 60, 90, 130, 0}};
+
+
+    // Defaults above are copied into the weights in use, which can be replaced by tuned ones
+    evaluation_weights make_default_weights() {
+        evaluation_weights default_weights{};
+        const int (*default_tables[6])[64]{pawn_table, knight_table, bishop_table, rook_table, queen_table, king_table};
+        for (int stage{} ; stage < 2 ; stage++) {
+            for (int piece{} ; piece < 6 ; piece++) {
+                default_weights.material_values[stage][piece] = material_values[stage][piece];
+                std::copy(default_tables[piece][stage], default_tables[piece][stage] + 64,
+                          default_weights.piece_square_tables[piece][stage]);
+            }
+            default_weights.doubled_pawn_penalty[stage] = doubled_pawn_penalty[stage];
+            default_weights.isolated_pawn_penalty[stage] = isolated_pawn_penalty[stage];
+            default_weights.backward_pawn_penalty[stage] = backward_pawn_penalty[stage];
+            std::copy(passed_pawn_bonus[stage], passed_pawn_bonus[stage] + 8, default_weights.passed_pawn_bonus[stage]);
+        }
+        return default_weights;
+    }
+
+    const evaluation_weights default_weights{make_default_weights()};
+    evaluation_weights current_weights{default_weights};
+
+
+    // Every weight array with its name, in the order used for parameter files and parameter vectors
+    template <typename weights_type, typename visitor_type>
+    void visit_weight_arrays(weights_type& weights, visitor_type visit) {
+        const char* piece_names[6]{"pawn", "knight", "bishop", "rook", "queen", "king"};
+        visit(std::string("material_values"), &weights.material_values[0][0], 2*6);
+        for (int piece{} ; piece < 6 ; piece++) {
+            visit(std::string(piece_names[piece]) + "_table", &weights.piece_square_tables[piece][0][0], 2*64);
+        }
+        visit(std::string("doubled_pawn_penalty"), weights.doubled_pawn_penalty, 2);
+        visit(std::string("isolated_pawn_penalty"), weights.isolated_pawn_penalty, 2);
+        visit(std::string("backward_pawn_penalty"), weights.backward_pawn_penalty, 2);
+        visit(std::string("passed_pawn_bonus"), &weights.passed_pawn_bonus[0][0], 2*8);
+    }
+
+
+    const evaluation_weights& get_default_weights() {
+        return default_weights;
+    }
+
+
+    const evaluation_weights& get_weights() {
+        return current_weights;
+    }
+
+
+    void set_weights(const evaluation_weights& new_weights) {
+        current_weights = new_weights;
+    }
+
+
+    std::vector<int> weights_to_parameters(const evaluation_weights& weights) {
+        std::vector<int> parameters;
+        visit_weight_arrays(weights, [&parameters](std::string /*name*/, const int* values, int number_of_values) {
+            parameters.insert(parameters.end(), values, values + number_of_values);
+        });
+        return parameters;
+    }
+
+
+    evaluation_weights parameters_to_weights(const std::vector<int>& parameters) {
+        if (parameters.size() != static_cast<size_t>(number_of_parameters)) {
+            throw std::invalid_argument("Wrong number of evaluation parameters");
+        }
+        evaluation_weights weights{};
+        size_t next_parameter{};
+        visit_weight_arrays(weights, [&parameters, &next_parameter](std::string /*name*/, int* values, int number_of_values) {
+            std::copy(parameters.begin() + next_parameter, parameters.begin() + next_parameter + number_of_values, values);
+            next_parameter += number_of_values;
+        });
+        return weights;
+    }
+
+
+    void save_weights(std::string file_name, const evaluation_weights& weights) {
+        // One line per weight array: its name, the number of values and then the values
+        std::ofstream weights_file{file_name};
+        if (!weights_file) {
+            throw std::ios_base::failure("Evaluation weights file could not be created");
+        }
+        weights_file << "# object-oriented-chess-game evaluation weights" << std::endl;
+        visit_weight_arrays(weights, [&weights_file](std::string name, const int* values, int number_of_values) {
+            weights_file << name << " " << number_of_values;
+            for (int i{} ; i < number_of_values ; i++) {
+                weights_file << " " << values[i];
+            }
+            weights_file << std::endl;
+        });
+        if (!weights_file) {
+            throw std::ios_base::failure("Evaluation weights could not be saved");
+        }
+    }
+
+
+    void load_weights(std::string file_name) {
+        std::ifstream weights_file{file_name};
+        if (!weights_file) {
+            throw std::ios_base::failure("Evaluation weights file could not be opened");
+        }
+        std::string comment;
+        std::getline(weights_file, comment);
+
+        // Arrays have to be in the same order and size as they are saved, so a file for
+        // a different set of weights is rejected rather than half loaded
+        evaluation_weights weights{};
+        visit_weight_arrays(weights, [&weights_file](std::string name, int* values, int number_of_values) {
+            std::string name_read;
+            int number_of_values_read{};
+            weights_file >> name_read >> number_of_values_read;
+            if (!weights_file || name_read != name || number_of_values_read != number_of_values) {
+                throw std::ios_base::failure("Evaluation weights file does not match the evaluation (expected " + name + ")");
+            }
+            for (int i{} ; i < number_of_values ; i++) {
+                weights_file >> values[i];
+            }
+            if (!weights_file) {
+                throw std::ios_base::failure("Evaluation weights file is missing values for " + name);
+            }
+        });
+        set_weights(weights);
+    }
+
+
+    int piece_square_value(char piece_symbol, pcs::color piece_color, int position, game_stage stage) {
+        // Board index 0 is a1, so white pieces are looked up with the rows flipped
+        // and black pieces use the table as if it were mirrored onto their side
+        int row{position/8};
+        int col{position%8};
+        int table_index{piece_color == pcs::white ? (7 - row)*8 + col : row*8 + col};
+        int piece{piece_type(piece_symbol)};
+        return current_weights.material_values[stage][piece] + current_weights.piece_square_tables[piece][stage][table_index];
+    }
+
+
+    int piece_type(char piece_symbol) {
+        switch (piece_symbol) {
+            case 'p': return 0;
+            case 'N': return 1;
+            case 'B': return 2;
+            case 'R': return 3;
+            case 'Q': return 4;
+            case 'K': return 5;
+            default:
+                throw std::invalid_argument("Invalid chess piece symbol");
+        }
+    }
+
+
+    int piece_phase(char piece_symbol) {
+        switch (piece_symbol) {
+            case 'p': return phase_values[0];
+            case 'N': return phase_values[1];
+            case 'B': return phase_values[2];
+            case 'R': return phase_values[3];
+            case 'Q': return phase_values[4];
+            case 'K': return phase_values[5];
+            default:
+                throw std::invalid_argument("Invalid chess piece symbol");
+        }
+    }
+
+
+    int tapered_score(int middlegame_score, int endgame_score, int game_phase) {
+        // Promotions can push the phase above its starting value
+        if (game_phase > max_game_phase) {
+            game_phase = max_game_phase;
+        }
+        return (middlegame_score*game_phase + endgame_score*(max_game_phase - game_phase))/max_game_phase;
+    }
+
+
+    pawn_structure_terms count_pawn_structure_terms(const brd::board& chess_board) {
+        // Pawn rows for each color and file, -1 where there isn't one
+        std::vector<int> pawn_rows[2][8];
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (piece && piece->get_symbol() == 'p') {
+                pawn_rows[piece->get_piece_color()][i%8].push_back(i/8);
+            }
+        }
+
+        pawn_structure_terms terms{};
+        for (int color{} ; color < 2 ; color++) {
+            int sign{color == pcs::white ? 1 : -1};
+            int opposition{color == pcs::white ? pcs::black : pcs::white};
+            int forward{color == pcs::white ? 1 : -1};
+
+            for (int file{} ; file < 8 ; file++) {
+                const std::vector<int>& file_pawns{pawn_rows[color][file]};
+                if (file_pawns.size() == 0) {
+                    continue;
+                }
+                if (file_pawns.size() > 1) {
+                    int extra_pawns{static_cast<int>(file_pawns.size()) - 1};
+                    terms.doubled_pawns += sign*extra_pawns;
+                }
+
+                bool has_neighbours{(file > 0 && pawn_rows[color][file - 1].size() > 0) ||
+                                    (file < 7 && pawn_rows[color][file + 1].size() > 0)};
+
+                for (int row : file_pawns) {
+                    if (!has_neighbours) {
+                        terms.isolated_pawns += sign;
+                    }
+
+                    // Passed if no opposition pawn is in front on this or a neighbouring file
+                    bool is_passed{true};
+                    // Backward if every neighbouring pawn is further up the board and the
+                    // square in front is guarded by an opposition pawn
+                    bool has_support{false};
+                    bool front_square_guarded{false};
+                    for (int neighbour_file{std::max(file - 1, 0)} ; neighbour_file <= std::min(file + 1, 7) ; neighbour_file++) {
+                        for (int opposition_row : pawn_rows[opposition][neighbour_file]) {
+                            if ((opposition_row - row)*forward > 0) {
+                                is_passed = false;
+                            }
+                            if (neighbour_file != file && opposition_row == row + 2*forward) {
+                                front_square_guarded = true;
+                            }
+                        }
+                        if (neighbour_file != file) {
+                            for (int friendly_row : pawn_rows[color][neighbour_file]) {
+                                if ((friendly_row - row)*forward <= 0) {
+                                    has_support = true;
+                                }
+                            }
+                        }
+                    }
+                    bool is_backward{has_neighbours && !has_support && front_square_guarded};
+
+                    if (is_backward) {
+                        terms.backward_pawns += sign;
+                    }
+                    if (is_passed) {
+                        int relative_rank{color == pcs::white ? row : 7 - row};
+                        terms.passed_pawns[relative_rank] += sign;
+                    }
+                }
+            }
+        }
+        return terms;
+    }
+
+
+    pawn_structure_score evaluate_pawn_structure(const brd::board& chess_board) {
+        pawn_structure_terms terms{count_pawn_structure_terms(chess_board)};
+        pawn_structure_score score{};
+        int stage_scores[2]{};
+        for (int stage{} ; stage < 2 ; stage++) {
+            stage_scores[stage] = -terms.doubled_pawns*current_weights.doubled_pawn_penalty[stage] -
+                                  terms.isolated_pawns*current_weights.isolated_pawn_penalty[stage] -
+                                  terms.backward_pawns*current_weights.backward_pawn_penalty[stage];
+            for (int rank{} ; rank < 8 ; rank++) {
+                stage_scores[stage] += terms.passed_pawns[rank]*current_weights.passed_pawn_bonus[stage][rank];
+            }
+        }
+        score.middlegame = stage_scores[middlegame];
+        score.endgame = stage_scores[endgame];
+        return score;
+    }
+
+
+    evaluation_features get_evaluation_features(const brd::board& chess_board) {
+        // Parameter numbers follow visit_weight_arrays: material values, the six piece-square
+        // tables and then the pawn structure weights, each split into middlegame and endgame halves
+        const int piece_square_offset{2*6};
+        const int doubled_pawn_offset{piece_square_offset + 6*2*64};
+        const int isolated_pawn_offset{doubled_pawn_offset + 2};
+        const int backward_pawn_offset{isolated_pawn_offset + 2};
+        const int passed_pawn_offset{backward_pawn_offset + 2};
+
+        evaluation_features features{};
+        std::vector<int> counts[2]{std::vector<int>(number_of_parameters), std::vector<int>(number_of_parameters)};
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (!piece) {
+                continue;
+            }
+            int sign{piece->get_piece_color() == pcs::white ? 1 : -1};
+            int row{i/8};
+            int table_index{piece->get_piece_color() == pcs::white ? (7 - row)*8 + i%8 : row*8 + i%8};
+            int piece_index{piece_type(piece->get_symbol())};
+            for (int stage{} ; stage < 2 ; stage++) {
+                counts[stage][stage*6 + piece_index] += sign;
+                counts[stage][piece_square_offset + piece_index*2*64 + stage*64 + table_index] += sign;
+            }
+            features.game_phase += piece_phase(piece->get_symbol());
+        }
+
+        pawn_structure_terms terms{count_pawn_structure_terms(chess_board)};
+        for (int stage{} ; stage < 2 ; stage++) {
+            counts[stage][doubled_pawn_offset + stage] -= terms.doubled_pawns;
+            counts[stage][isolated_pawn_offset + stage] -= terms.isolated_pawns;
+            counts[stage][backward_pawn_offset + stage] -= terms.backward_pawns;
+            for (int rank{} ; rank < 8 ; rank++) {
+                counts[stage][passed_pawn_offset + stage*8 + rank] += terms.passed_pawns[rank];
+            }
+        }
+
+        for (int stage{} ; stage < 2 ; stage++) {
+            for (int parameter{} ; parameter < number_of_parameters ; parameter++) {
+                if (counts[stage][parameter] != 0) {
+                    features.terms[stage].push_back(std::pair<int, int>(parameter, counts[stage][parameter]));
+                }
+            }
+        }
+        features.game_phase = std::min(features.game_phase, max_game_phase);
+        return features;
+    }
+}
+
+
+evl::pawn_structure_score evl::pawn_hash_table::get_score(const brd::board& chess_board) {
+    std::uint64_t key{chess_board.get_pawn_hash()};
+    pawn_entry& entry{entries[key%entries.size()]};
+
+    ++probes;
+    if (entry.is_used && entry.key == key) {
+        ++hits;
+        return entry.score;
+    }
+    entry.key = key;
+    entry.score = evaluate_pawn_structure(chess_board);
+    entry.is_used = true;
+    return entry.score;
+}
+
+
+void evl::pawn_hash_table::clear() {
+    std::fill(entries.begin(), entries.end(), pawn_entry{});
+    probes = 0;
+    hits = 0;
+}
@@ -0,0 +1,380 @@
+// object-oriented-chess-game/game_archive.cpp
+//
+// Source file for the compact binary file of games
+// kept alongside portable game notation
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <ios>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "pgn_reader.hpp"
+#include "pgn_import.hpp"
+#include "san.hpp"
+#include "game_archive.hpp"
+
+
+// Class and function definitions
+namespace cgm {
+    const char archive_magic[8]{'O', 'O', 'C', 'G', 'G', 'A', 'M', 'E'};
+    const int archive_header_size{16};
+    // Tag names stored as their position in this list plus one. Only ever added to, at the end,
+    // or files written earlier would read back with the wrong names
+    const char* const common_tag_names[]{"Event", "Site", "Date", "Round", "White", "Black", "Result",
+                                         "FEN", "SetUp", "ECO", "WhiteElo", "BlackElo", "TimeControl",
+                                         "Termination", "Annotator", "PlyCount", "EventDate", "Opening",
+                                         "Variation"};
+    const int number_of_common_tags{sizeof(common_tag_names)/sizeof(common_tag_names[0])};
+    const char* const result_names[]{"*", "1-0", "0-1", "1/2-1/2"};
+    const char promotion_symbols[]{'Q', 'R', 'B', 'N'};
+    // Result, 255 tags with the longest names and values, and 65535 moves
+    const std::uint32_t max_archive_record_size{1 + 1 + 0xff*(1 + 1 + 0xff + 2 + 0xffff) + 2 + 2*0xffff};
+
+    void append_uint16(std::vector<unsigned char>& bytes, std::uint32_t value) {
+        bytes.push_back(static_cast<unsigned char>(value & 0xff));
+        bytes.push_back(static_cast<unsigned char>((value >> 8) & 0xff));
+    }
+
+
+    void append_uint32(std::vector<unsigned char>& bytes, std::uint32_t value) {
+        for (int i{} ; i < 4 ; i++) {
+            bytes.push_back(static_cast<unsigned char>(value >> (8*i)));
+        }
+    }
+
+
+    std::uint32_t read_little_endian(const unsigned char* bytes, int number_of_bytes) {
+        std::uint32_t value{};
+        for (int i{} ; i < number_of_bytes ; i++) {
+            value |= static_cast<std::uint32_t>(bytes[i]) << (8*i);
+        }
+        return value;
+    }
+
+
+    std::uint16_t encode_move(const eng::move& chosen_move) {
+        int promotion_code{};
+        for (int i{} ; i < 4 ; i++) {
+            if (chosen_move.promotion_symbol == promotion_symbols[i]) {
+                promotion_code = i + 1;
+            }
+        }
+        return static_cast<std::uint16_t>(chosen_move.start_position | chosen_move.end_position << 6 | promotion_code << 12);
+    }
+
+
+    eng::move decode_move(std::uint16_t move_code) {
+        int promotion_code{move_code >> 12};
+        if (promotion_code > 4) {
+            throw std::invalid_argument("Error: Invalid move code " + std::to_string(move_code));
+        }
+        return eng::move{move_code & 0x3f, (move_code >> 6) & 0x3f, promotion_code == 0 ? '\0' : promotion_symbols[promotion_code - 1]};
+    }
+
+
+    void play_archived_move(brd::board& chess_board, pcs::color side_to_move, const eng::move& archived_move) {
+        // Archives can be damaged or edited by hand, so each move goes through the same checks as moves read
+        // from PGN. A move that exposes the king is only found once it is played, which is why the board
+        // is of no use after an illegal move
+        if (!is_pseudo_legal(chess_board, side_to_move, archived_move)) {
+            throw std::invalid_argument("Error: Illegal move " + eng::move_to_string(archived_move));
+        }
+        eng::make_move(chess_board, archived_move);
+        if (eng::is_in_check(chess_board, side_to_move)) {
+            throw std::invalid_argument("Error: Illegal move " + eng::move_to_string(archived_move));
+        }
+    }
+
+
+    std::vector<std::string> moves_to_san(const pgn_game& game, const std::vector<eng::move>& moves) {
+        std::unique_ptr<brd::board> chess_board;
+        pcs::color side_to_move{pcs::white};
+        std::string fen{game.get_tag("FEN")};
+        if (fen.empty()) {
+            chess_board.reset(new brd::board{});
+        } else {
+            std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> position{brd::read_fen(fen)};
+            chess_board.reset(new brd::board{position.first});
+            side_to_move = position.second;
+        }
+        std::vector<std::string> notations;
+        for (auto move_iterator = moves.begin() ; move_iterator != moves.end() ; move_iterator++) {
+            try {
+                if (!is_pseudo_legal(*chess_board, side_to_move, *move_iterator)) {
+                    throw std::invalid_argument("Error: Illegal move " + eng::move_to_string(*move_iterator));
+                }
+                std::string notation{move_to_san(*chess_board, side_to_move, *move_iterator)};
+                play_archived_move(*chess_board, side_to_move, *move_iterator);
+                notations.push_back(notation);
+            } catch (const std::invalid_argument& e) {
+                throw std::invalid_argument("Move " + std::to_string(notations.size() + 1) + ": " + e.what());
+            }
+            side_to_move = pcs::opposite_color(side_to_move);
+        }
+        return notations;
+    }
+
+
+    void write_pgn_game(std::ostream& pgn_output, const pgn_game& game) {
+        for (auto tag_iterator = game.tags.begin() ; tag_iterator != game.tags.end() ; tag_iterator++) {
+            std::string value;
+            for (auto character_iterator = tag_iterator->second.begin() ; character_iterator != tag_iterator->second.end() ; character_iterator++) {
+                if (*character_iterator == '\\' || *character_iterator == '"') {
+                    value += '\\';
+                }
+                value += *character_iterator;
+            }
+            pgn_output << "[" << tag_iterator->first << " \"" << value << "\"]\n";
+        }
+        pgn_output << "\n";
+
+        // Move numbers carry on from the starting position's, which might have black to move
+        int move_number{1};
+        bool is_white_to_move{true};
+        std::string fen{game.get_tag("FEN")};
+        if (!fen.empty()) {
+            std::istringstream fen_fields{fen};
+            std::string field;
+            for (int i{} ; i < 6 && fen_fields >> field ; i++) {
+                if (i == 1) {
+                    is_white_to_move = field != "b";
+                } else if (i == 5) {
+                    move_number = std::max(1, std::atoi(field.c_str()));
+                }
+            }
+        }
+
+        std::string line;
+        auto add_token = [&](const std::string& token) {
+            if (!line.empty() && line.size() + 1 + token.size() > 80) {
+                pgn_output << line << "\n";
+                line.clear();
+            }
+            line += line.empty() ? token : " " + token;
+        };
+        for (auto move_iterator = game.moves.begin() ; move_iterator != game.moves.end() ; move_iterator++) {
+            if (is_white_to_move) {
+                add_token(std::to_string(move_number) + ". " + *move_iterator);
+            } else {
+                add_token(move_iterator == game.moves.begin() ? std::to_string(move_number) + "... " + *move_iterator : *move_iterator);
+                move_number++;
+            }
+            is_white_to_move = !is_white_to_move;
+        }
+        add_token(game.result.empty() ? "*" : game.result);
+        pgn_output << line << "\n\n";
+    }
+
+
+    pgn_import_summary convert_pgn_to_archive(std::string pgn_file_name, std::string archive_file_name,
+                                              const pgn_import_options& options) {
+        game_archive_writer writer{archive_file_name};
+        pgn_import_options replaying_options{options};
+        replaying_options.replay_moves = true;
+        // Games are handed over one at a time, in order, so the writer needs no lock of its own
+        pgn_import_summary summary{import_pgn_database(pgn_file_name, replaying_options, [&](const imported_game& game) {
+            if (game.is_valid) {
+                writer.write(game.game, game.replayed_moves);
+            }
+        })};
+        writer.close();
+        return summary;
+    }
+
+
+    long long convert_archive_to_pgn(std::string archive_file_name, std::string pgn_file_name) {
+        game_archive_reader reader{archive_file_name};
+        std::ofstream pgn_file{pgn_file_name};
+        if (!pgn_file) {
+            throw std::ios_base::failure("PGN file could not be created");
+        }
+        pgn_game game;
+        std::vector<eng::move> moves;
+        while (reader.read_game(game, moves)) {
+            game.moves = moves_to_san(game, moves);
+            write_pgn_game(pgn_file, game);
+        }
+        pgn_file.close();
+        if (!pgn_file) {
+            throw std::ios_base::failure("PGN file could not be written");
+        }
+        return reader.get_games_read();
+    }
+}
+
+
+cgm::game_archive_writer::game_archive_writer(std::string file_name) {
+    archive_file.open(file_name, std::ios::binary | std::ios::trunc);
+    if (!archive_file) {
+        throw std::ios_base::failure("Game archive could not be created");
+    }
+    unsigned char header[archive_header_size]{};
+    std::memcpy(header, archive_magic, sizeof(archive_magic));
+    std::vector<unsigned char> fields;
+    append_uint32(fields, game_archive_version);
+    std::memcpy(header + 8, fields.data(), fields.size());
+    archive_file.write(reinterpret_cast<const char*>(header), archive_header_size);
+}
+
+
+void cgm::game_archive_writer::write(const pgn_game& game, const std::vector<eng::move>& moves) {
+    if (game.tags.size() > 0xff || moves.size() > 0xffff) {
+        throw std::invalid_argument("Error: Game is too long to archive");
+    }
+    // The size is filled in once the rest of the record is built
+    record.assign(4, 0);
+    int result_code{};
+    for (int i{} ; i < 4 ; i++) {
+        if (game.result == result_names[i]) {
+            result_code = i;
+        }
+    }
+    record.push_back(static_cast<unsigned char>(result_code));
+    record.push_back(static_cast<unsigned char>(game.tags.size()));
+    for (auto tag_iterator = game.tags.begin() ; tag_iterator != game.tags.end() ; tag_iterator++) {
+        if (tag_iterator->first.size() > 0xff || tag_iterator->second.size() > 0xffff) {
+            throw std::invalid_argument("Error: Tag " + tag_iterator->first + " is too long to archive");
+        }
+        int tag_code{};
+        for (int i{} ; i < number_of_common_tags ; i++) {
+            if (tag_iterator->first == common_tag_names[i]) {
+                tag_code = i + 1;
+            }
+        }
+        record.push_back(static_cast<unsigned char>(tag_code));
+        if (tag_code == 0) {
+            record.push_back(static_cast<unsigned char>(tag_iterator->first.size()));
+            record.insert(record.end(), tag_iterator->first.begin(), tag_iterator->first.end());
+        }
+        append_uint16(record, static_cast<std::uint32_t>(tag_iterator->second.size()));
+        record.insert(record.end(), tag_iterator->second.begin(), tag_iterator->second.end());
+    }
+    append_uint16(record, static_cast<std::uint32_t>(moves.size()));
+    for (auto move_iterator = moves.begin() ; move_iterator != moves.end() ; move_iterator++) {
+        append_uint16(record, encode_move(*move_iterator));
+    }
+    std::vector<unsigned char> record_size;
+    append_uint32(record_size, static_cast<std::uint32_t>(record.size() - 4));
+    std::memcpy(record.data(), record_size.data(), 4);
+
+    archive_file.write(reinterpret_cast<const char*>(record.data()), record.size());
+    if (!archive_file) {
+        throw std::ios_base::failure("Game archive could not be written");
+    }
+    ++games_written;
+}
+
+
+void cgm::game_archive_writer::flush() {
+    archive_file.flush();
+    if (!archive_file) {
+        throw std::ios_base::failure("Game archive could not be written");
+    }
+}
+
+
+void cgm::game_archive_writer::close() {
+    archive_file.close();
+    if (!archive_file) {
+        throw std::ios_base::failure("Game archive could not be closed");
+    }
+}
+
+
+cgm::game_archive_reader::game_archive_reader(std::string file_name) {
+    archive_file.open(file_name, std::ios::binary);
+    if (!archive_file) {
+        throw std::ios_base::failure("Game archive could not be opened");
+    }
+    unsigned char header[archive_header_size]{};
+    archive_file.read(reinterpret_cast<char*>(header), archive_header_size);
+    if (!archive_file || std::memcmp(header, archive_magic, sizeof(archive_magic)) != 0) {
+        throw std::ios_base::failure("File is not a game archive");
+    }
+    if (read_little_endian(header + 8, 4) != game_archive_version) {
+        throw std::ios_base::failure("Game archive was written by a different version of the program");
+    }
+    archive_file.seekg(0, std::ios::end);
+    bytes_left = static_cast<std::uint64_t>(archive_file.tellg()) - archive_header_size;
+    archive_file.seekg(archive_header_size);
+}
+
+
+bool cgm::game_archive_reader::read_game(pgn_game& game, std::vector<eng::move>& moves) {
+    unsigned char record_size_bytes[4]{};
+    archive_file.read(reinterpret_cast<char*>(record_size_bytes), 4);
+    if (archive_file.gcount() == 0 && archive_file.eof()) {
+        return false;
+    }
+    // The size is checked before any memory is set aside for it, as a damaged one could be up to 4 GB
+    std::uint32_t record_size{read_little_endian(record_size_bytes, 4)};
+    if (record_size > max_archive_record_size) {
+        throw std::ios_base::failure("Game " + std::to_string(games_read + 1) + " of the archive is not valid");
+    }
+    if (bytes_left < 4 + static_cast<std::uint64_t>(record_size)) {
+        throw std::ios_base::failure("Game archive ends part way through a game");
+    }
+    bytes_left -= 4 + record_size;
+    record.resize(record_size);
+    archive_file.read(reinterpret_cast<char*>(record.data()), record.size());
+    if (!archive_file) {
+        throw std::ios_base::failure("Game archive ends part way through a game");
+    }
+
+    // Every field is checked against the record's size, so a damaged record can't be read past
+    size_t position{};
+    auto take = [&](size_t number_of_bytes) {
+        if (record.size() - position < number_of_bytes) {
+            throw std::ios_base::failure("Game " + std::to_string(games_read + 1) + " of the archive is not valid");
+        }
+        const unsigned char* bytes{record.data() + position};
+        position += number_of_bytes;
+        return bytes;
+    };
+    game.clear();
+    moves.clear();
+    int result_code{*take(1)};
+    if (result_code > 3) {
+        throw std::ios_base::failure("Game " + std::to_string(games_read + 1) + " of the archive is not valid");
+    }
+    game.result = result_names[result_code];
+    int number_of_tags{*take(1)};
+    for (int i{} ; i < number_of_tags ; i++) {
+        int tag_code{*take(1)};
+        std::string tag_name;
+        if (tag_code == 0) {
+            size_t name_length{*take(1)};
+            const unsigned char* name{take(name_length)};
+            tag_name.assign(name, name + name_length);
+        } else if (tag_code <= number_of_common_tags) {
+            tag_name = common_tag_names[tag_code - 1];
+        } else {
+            throw std::ios_base::failure("Game " + std::to_string(games_read + 1) + " of the archive is not valid");
+        }
+        size_t value_length{read_little_endian(take(2), 2)};
+        const unsigned char* value{take(value_length)};
+        game.tags.emplace_back(tag_name, std::string(value, value + value_length));
+    }
+    size_t number_of_moves{read_little_endian(take(2), 2)};
+    const unsigned char* move_codes{take(2*number_of_moves)};
+    moves.reserve(number_of_moves);
+    for (size_t i{} ; i < number_of_moves ; i++) {
+        moves.push_back(decode_move(static_cast<std::uint16_t>(read_little_endian(move_codes + 2*i, 2))));
+    }
+    ++games_read;
+    return true;
+}
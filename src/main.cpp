@@ -8,9 +8,28 @@
 #include <string>
 #include <memory>
 #include <limits>
+#include <exception>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <ios>
 #include "chess_pieces.hpp"
 #include "player.hpp"
 #include "chess_game.hpp"
+#include "neural_network.hpp"
+#include "opening_book.hpp"
+#include "tablebase.hpp"
+#include "mate_solver.hpp"
+#include "evaluation.hpp"
+#include "training_data.hpp"
+#include "tuning.hpp"
+#include "self_play.hpp"
+#include "batch_analysis.hpp"
+#include "pgn_import.hpp"
+#include "game_archive.hpp"
 
 
 // Function declarations
@@ -18,27 +37,334 @@ int get_valid_input(int valid_input_one, int valid_input_two);
 bool ask_for_yes_or_no(std::string question, std::string invalid_input_response);
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Optional command line settings
+    plr::engine_mode bot_mode{plr::alpha_beta_search};
+    std::shared_ptr<book::opening_book> opening_book;
+    int hint_latency_ms{500};
+    // Zero keeps the bot's default transposition table size
+    int hash_megabytes{0};
+    std::string hash_file_name{};
+    for (int i{1} ; i < argc ; i++) {
+        std::string argument{argv[i]};
+        if (argument == "--nnue" && i + 1 < argc) {
+            // Neural network evaluation for the chess bot
+            try {
+                nnue::load_network(argv[++i]);
+                std::cout << "Loaded neural network evaluation (using " 
+                          << nnue::simd_level_to_string(nnue::get_simd_level()) << " instructions)" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                std::cout << "ChessBot will use its standard evaluation" << std::endl;
+            }
+        } else if (argument == "--mcts") {
+            // Monte Carlo tree search instead of alpha-beta for the chess bot
+            bot_mode = plr::monte_carlo_tree_search;
+        } else if (argument == "--book" && i + 1 < argc) {
+            // Polyglot opening book for the chess bot
+            try {
+                opening_book = std::make_shared<book::opening_book>(argv[++i]);
+                std::cout << "Loaded opening book with " << opening_book->get_number_of_entries() << " entries" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                std::cout << "ChessBot will play without an opening book" << std::endl;
+                opening_book.reset();
+            }
+        } else if (argument == "--hint-latency" && i + 1 < argc) {
+            // Longest time a hint may take, in milliseconds
+            try {
+                hint_latency_ms = std::max(0, std::stoi(argv[++i]));
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid hint latency, using " << hint_latency_ms << " ms" << std::endl;
+            }
+        } else if (argument == "--hash" && i + 1 < argc) {
+            // Transposition table size for the chess bot, in megabytes
+            try {
+                hash_megabytes = std::max(1, std::stoi(argv[++i]));
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid hash size, using the default" << std::endl;
+            }
+        } else if (argument == "--hash-file" && i + 1 < argc) {
+            // Transposition table file, loaded at the start of the session and saved at the end
+            hash_file_name = argv[++i];
+        } else if (argument == "--solve-mate" && i + 1 < argc) {
+            // Mate-in-N solver for a FEN position, e.g. --solve-mate "<FEN>" 3, which exits once solved
+            std::string fen{argv[++i]};
+            eng::mate_solver_options solver_settings{};
+            if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                try {
+                    solver_settings.max_moves = std::max(1, std::stoi(argv[++i]));
+                } catch (const std::exception& e) {
+                    std::cerr << "Invalid number of moves, looking for mates in up to " << solver_settings.max_moves << std::endl;
+                }
+            }
+            try {
+                std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> position{brd::read_fen(fen)};
+                brd::board chess_board{position.first};
+                eng::mate_solver solver{solver_settings};
+                eng::mate_result result{solver.solve(chess_board, position.second)};
+                if (result.found) {
+                    std::cout << pcs::color_to_string(position.second) << " mates in " << result.moves_to_mate << ":";
+                    for (auto move_iterator = result.mating_line.begin() ; move_iterator != result.mating_line.end() ; move_iterator++) {
+                        std::cout << " " << eng::move_to_string(*move_iterator);
+                    }
+                    std::cout << std::endl;
+                } else if (result.node_limit_reached) {
+                    std::cout << "No mate found before the node limit was reached" << std::endl;
+                } else {
+                    std::cout << "No mate in " << solver_settings.max_moves << " moves or fewer" << std::endl;
+                }
+                std::cout << "(" << result.nodes_searched << " nodes)" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--multipv" && i + 1 < argc) {
+            // Best lines for a FEN position, e.g. --multipv "<FEN>" 3 6 for three lines at depth six, which exits once done
+            std::string fen{argv[++i]};
+            int number_of_lines{3};
+            int depth{6};
+            try {
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    number_of_lines = std::max(1, std::stoi(argv[++i]));
+                }
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    depth = std::max(1, std::min(eng::max_search_ply - 1, std::stoi(argv[++i])));
+                }
+                std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> position{brd::read_fen(fen)};
+                brd::board chess_board{position.first};
+                eng::search analysis_search{};
+                std::vector<eng::analysed_line> lines{analysis_search.find_best_lines(chess_board, position.second, depth,
+                                                                                      number_of_lines)};
+                for (size_t j{} ; j < lines.size() ; j++) {
+                    std::cout << j + 1 << ". " << eng::score_to_string(lines[j].score) << " (depth " << lines[j].depth << "):";
+                    for (auto move_iterator = lines[j].principal_variation.begin() ;
+                         move_iterator != lines[j].principal_variation.end() ; move_iterator++) {
+                        std::cout << " " << eng::move_to_string(*move_iterator);
+                    }
+                    std::cout << std::endl;
+                }
+                std::cout << "(" << analysis_search.get_nodes_searched() << " nodes)" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--analyse" && i + 1 < argc) {
+            // Analyses a file of FENs, one per line ("-" reads them from standard input), on every core, e.g.
+            // --analyse positions.txt 10 500000 2000 for depth ten, half a million nodes and two seconds at most
+            // per position, with zero for no limit. Writes JSON lines to standard output, then exits
+            std::string fen_file_name{argv[++i]};
+            eng::batch_analysis_options analysis_settings{};
+            if (hash_megabytes > 0) {
+                analysis_settings.transposition_table_entries = eng::transposition_table_entries_for_megabytes(hash_megabytes);
+            }
+            try {
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    int depth{std::stoi(argv[++i])};
+                    analysis_settings.max_depth = depth > 0 ? std::min(eng::max_search_ply - 1, depth) : eng::max_search_ply - 1;
+                }
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    analysis_settings.max_nodes = std::max(0LL, std::stoll(argv[++i]));
+                }
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    analysis_settings.max_time_ms = std::max(0, std::stoi(argv[++i]));
+                }
+                if (analysis_settings.max_depth == eng::max_search_ply - 1 && analysis_settings.max_nodes == 0 &&
+                    analysis_settings.max_time_ms == 0) {
+                    throw std::invalid_argument("Analysis needs a depth, node or time limit");
+                }
+                eng::batch_analysis_summary summary{};
+                if (fen_file_name == "-") {
+                    summary = eng::analyse_positions(std::cin, std::cout, analysis_settings);
+                } else {
+                    std::ifstream fen_file{fen_file_name};
+                    if (!fen_file) {
+                        throw std::ios_base::failure("Could not open " + fen_file_name);
+                    }
+                    summary = eng::analyse_positions(fen_file, std::cout, analysis_settings);
+                }
+                // Kept off standard output, which only holds the results
+                std::cerr << "Analysed " << summary.positions_analysed << " positions (" << summary.invalid_positions
+                          << " invalid) in " << summary.seconds << " s, " << summary.nodes_searched << " nodes" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--eval-weights" && i + 1 < argc) {
+            // Tuned evaluation weights for the chess bot, in place of the built in ones
+            try {
+                evl::load_weights(argv[++i]);
+                std::cout << "Loaded evaluation weights" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                std::cout << "ChessBot will use its built in evaluation weights" << std::endl;
+            }
+        } else if (argument == "--pack-positions" && i + 2 < argc) {
+            // Converts FENs labelled with results into the binary training data format, then exits
+            try {
+                std::string text_file_name{argv[++i]};
+                std::string data_file_name{argv[++i]};
+                long long positions_written{trn::pack_labelled_positions(text_file_name, data_file_name)};
+                std::cout << "Wrote " << positions_written << " positions to " << data_file_name << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--tune" && i + 2 < argc) {
+            // Tunes the evaluation weights on binary training data, e.g. --tune positions.bin weights.txt 200,
+            // starting from the weights in use, then exits
+            std::string data_file_name{argv[++i]};
+            std::string weights_file_name{argv[++i]};
+            tun::tuning_options tuning_settings{};
+            try {
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    tuning_settings.epochs = std::max(1, std::stoi(argv[++i]));
+                }
+                tun::evaluation_tuner tuner{tuning_settings};
+                auto loading_start = std::chrono::steady_clock::now();
+                size_t number_of_positions{tuner.load_positions(data_file_name)};
+                double loading_seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - loading_start).count()};
+                std::cout << "Loaded " << number_of_positions << " quiet positions in " << loading_seconds << " s" << std::endl;
+                evl::save_weights(weights_file_name, tuner.tune(evl::get_weights()));
+                std::cout << "Saved tuned weights to " << weights_file_name << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--self-play" && i + 1 < argc) {
+            // Bot against bot games on every core, appending their positions to binary training data,
+            // e.g. --self-play positions.bin 1000 4 for a thousand games searched to depth four, then exits.
+            // Uses the opening book, tablebases and evaluation given before it
+            std::string data_file_name{argv[++i]};
+            trn::self_play_options self_play_settings{};
+            self_play_settings.opening_book = opening_book;
+            if (hash_megabytes > 0) {
+                self_play_settings.transposition_table_entries = eng::transposition_table_entries_for_megabytes(hash_megabytes);
+            }
+            try {
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    self_play_settings.number_of_games = std::max(1, std::stoi(argv[++i]));
+                }
+                if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                    self_play_settings.search_depth = std::max(1, std::min(eng::max_search_ply - 1, std::stoi(argv[++i])));
+                }
+                trn::self_play_summary summary{trn::generate_self_play_data(data_file_name, self_play_settings)};
+                std::cout << "Played " << summary.games_played << " games (white won " << summary.white_wins << ", black won "
+                          << summary.black_wins << ", " << summary.draws << " drawn) in " << summary.seconds << " s" << std::endl;
+                std::cout << "Wrote " << summary.positions_written << " positions to " << data_file_name << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--import-pgn" && i + 1 < argc) {
+            // Reads and checks every game of a PGN database on every core, reporting the games that
+            // aren't valid, e.g. --import-pgn games.pgn, then exits
+            std::string pgn_file_name{argv[++i]};
+            try {
+                const int max_errors_shown{10};
+                int errors_shown{};
+                cgm::pgn_import_summary summary{cgm::import_pgn_database(pgn_file_name, cgm::pgn_import_options{},
+                    [&](const cgm::imported_game& game) {
+                        if (!game.is_valid && errors_shown++ < max_errors_shown) {
+                            std::cout << "Game " << game.game_number << ": " << game.error << std::endl;
+                        }
+                    })};
+                std::cout << "Imported " << summary.games_imported << " games (" << summary.invalid_games << " invalid) with "
+                          << summary.moves_replayed << " moves in " << summary.seconds << " s ("
+                          << static_cast<long long>(summary.games_imported/std::max(summary.seconds, 1e-9)) << " games/s)" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--pgn-to-archive" && i + 2 < argc) {
+            // Converts a PGN database into the compact binary game format, leaving out games that
+            // aren't valid, e.g. --pgn-to-archive games.pgn games.ccg, then exits
+            try {
+                std::string pgn_file_name{argv[++i]};
+                std::string archive_file_name{argv[++i]};
+                cgm::pgn_import_summary summary{cgm::convert_pgn_to_archive(pgn_file_name, archive_file_name, cgm::pgn_import_options{})};
+                std::cout << "Wrote " << summary.games_imported - summary.invalid_games << " games to " << archive_file_name
+                          << " (" << summary.invalid_games << " invalid games left out) in " << summary.seconds << " s" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--archive-to-pgn" && i + 2 < argc) {
+            // Writes the games of a binary game file back out as PGN, then exits
+            try {
+                std::string archive_file_name{argv[++i]};
+                std::string pgn_file_name{argv[++i]};
+                long long games_written{cgm::convert_archive_to_pgn(archive_file_name, pgn_file_name)};
+                std::cout << "Wrote " << games_written << " games to " << pgn_file_name << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        } else if (argument == "--tablebases") {
+            // Endgame tablebases, optionally kept in a directory so they are only generated once
+            std::string directory{};
+            if (i + 1 < argc && std::string(argv[i + 1]).find("--") != 0) {
+                directory = argv[++i];
+            }
+            std::cout << "Preparing endgame tablebases (KQK, KRK, KPK, KBNK)..." << std::endl;
+            try {
+                egtb::generate_tablebases(directory);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+    }
+
     std::cout << "Please enter the number of players (1/2): ";
     int number_of_players{};
     number_of_players = get_valid_input(1, 2);
     
     plr::human_player player_one;
+    player_one.set_hint_latency(hint_latency_ms);
     std::cout << "Player 1" << std::endl;
     player_one.ask_for_name();
     player_one.ask_for_color();
     std::cout << player_one.get_name() << " your color is " << pcs::color_to_string(player_one.get_piece_color()) << std::endl;
 
     std::shared_ptr<plr::player> player_two;
+    std::shared_ptr<plr::chess_bot> chess_bot;
     if (number_of_players == 1) {
-        player_two = std::make_shared<plr::chess_bot>(pcs::opposite_color(player_one.get_piece_color()));
+        chess_bot = std::make_shared<plr::chess_bot>(pcs::opposite_color(player_one.get_piece_color()), bot_mode);
+        chess_bot->set_opening_book(opening_book);
+        if (hash_megabytes > 0) {
+            chess_bot->resize_transposition_table(eng::transposition_table_entries_for_megabytes(hash_megabytes));
+        }
+        if (!hash_file_name.empty()) {
+            try {
+                chess_bot->get_engine_context()->load_transposition_table(hash_file_name);
+                std::cout << "Loaded transposition table with " << chess_bot->get_engine_context()->get_transposition_table_size()
+                          << " entries" << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                std::cout << "ChessBot will start with an empty transposition table" << std::endl;
+            }
+        }
+        player_two = chess_bot;
     } else {
         std::cout << "Player 2" << std::endl;
-        player_two = std::make_shared<plr::human_player>(pcs::opposite_color(player_one.get_piece_color()));
+        std::shared_ptr<plr::human_player> human_player_two{std::make_shared<plr::human_player>(
+                                                                pcs::opposite_color(player_one.get_piece_color()))};
+        human_player_two->set_hint_latency(hint_latency_ms);
+        player_two = human_player_two;
         player_two->ask_for_name();
         std::cout << player_two->get_name() << " your color is " << pcs::color_to_string(player_two->get_piece_color()) << std::endl;
     }
 
+    // The bot (and its engine context) is created once, so each new game starts with what it learnt in the last
     bool keep_playing{true};
     while (keep_playing) {
         cgm::chess_game game(player_one, player_two);
@@ -75,8 +401,16 @@ int main() {
             game.promote_pawn_if_possible();
 
             game.update_game_status();
+
+            // Bot keeps thinking on the human's time, its search is stopped when its turn comes round
+            if (chess_bot && game.get_current_player() == chess_bot && !game.has_ended()) {
+                chess_bot->start_pondering(game.get_chess_board());
+            }
             game.get_next_player_ready();
         }
+        if (chess_bot) {
+            chess_bot->stop_pondering();
+        }
 
         game.game_over();
 
@@ -95,6 +429,14 @@ int main() {
 
     cgm::chess_game::display_stats(player_one.get_name(), player_two->get_name());
 
+    if (chess_bot && !hash_file_name.empty()) {
+        try {
+            chess_bot->get_engine_context()->save_transposition_table(hash_file_name);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
     return 0;
 }
 
@@ -0,0 +1,246 @@
+// object-oriented-chess-game/mate_solver.cpp
+//
+// Source file for the mate-in-N solver using
+// depth-first proof-number search
+//
+// Author: Jason Dominguez
+
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "mate_solver.hpp"
+
+
+// Class and function definitions
+namespace eng {
+    // Proof and disproof numbers at or above this are treated as infinite
+    const std::uint32_t infinite_proof_number{100000000};
+    const std::uint32_t quiet_move_proof_number{2};
+
+    std::uint32_t add_proof_numbers(std::uint32_t first, std::uint32_t second) {
+        return static_cast<std::uint32_t>(std::min<std::uint64_t>(static_cast<std::uint64_t>(first) + second,
+                                                                  infinite_proof_number));
+    }
+}
+
+
+eng::mate_solver::mate_solver() : table(options.hash_entries) {}
+
+
+eng::mate_solver::mate_solver(const mate_solver_options& solver_settings) : options{solver_settings} {
+    if (options.max_moves < 1 || options.hash_entries == 0) {
+        throw std::invalid_argument("Mate solver needs at least one move and one hash entry");
+    }
+    table.resize(options.hash_entries);
+}
+
+
+void eng::mate_solver::clear() {
+    std::fill(table.begin(), table.end(), pn_entry{});
+}
+
+
+std::uint64_t eng::mate_solver::node_key(const brd::board& chess_board, pcs::color side_to_move, bool is_attacker,
+                                         int moves_left) const {
+    // The same position is a different problem with a different number of moves left to mate in
+    std::uint64_t depth_key{static_cast<std::uint64_t>(2*moves_left + (is_attacker ? 1 : 0) + 1)*0x9e3779b97f4a7c15ULL};
+    return position_hash(chess_board, side_to_move) ^ depth_key;
+}
+
+
+bool eng::mate_solver::lookup(std::uint64_t key, std::uint32_t& phi, std::uint32_t& delta) const {
+    // Unexplored nodes count as a single leaf to prove and a single leaf to disprove
+    const pn_entry& entry{table[key%table.size()]};
+    if (entry.is_used && entry.key == key) {
+        phi = entry.phi;
+        delta = entry.delta;
+        return true;
+    }
+    phi = 1;
+    delta = 1;
+    return false;
+}
+
+
+void eng::mate_solver::store(std::uint64_t key, std::uint32_t phi, std::uint32_t delta) {
+    table[key%table.size()] = pn_entry{key, phi, delta, true};
+}
+
+
+void eng::mate_solver::multiple_iterative_deepening(const brd::board& chess_board, pcs::color side_to_move, bool is_attacker,
+                                                    int moves_left, std::uint32_t phi_threshold, std::uint32_t delta_threshold) {
+    ++nodes_searched;
+    std::uint64_t key{node_key(chess_board, side_to_move, is_attacker, moves_left)};
+
+    // Values for a node won or lost by its side to move
+    const std::uint32_t won[2]{0, infinite_proof_number};
+    const std::uint32_t lost[2]{infinite_proof_number, 0};
+
+    // Once the attacker has used its last move only checkmate counts, which needs no move
+    // generation unless the defender is in check
+    bool in_check{is_in_check(chess_board, side_to_move)};
+    if (moves_left == 0 && (is_attacker || !in_check)) {
+        const std::uint32_t* result{is_attacker ? lost : won};
+        store(key, result[0], result[1]);
+        return;
+    }
+
+    std::vector<move> moves{generate_legal_moves(chess_board, side_to_move)};
+    if (moves.empty()) {
+        // Checkmate is only a win for the attacker when the defender is the one mated, stalemate never is
+        const std::uint32_t* result{is_attacker || in_check ? lost : won};
+        store(key, result[0], result[1]);
+        return;
+    }
+    if (moves_left == 0) {
+        // Defender escaped the last check
+        store(key, won[0], won[1]);
+        return;
+    }
+
+    pcs::color opposition_color{pcs::opposite_color(side_to_move)};
+    int child_moves_left{is_attacker ? moves_left - 1 : moves_left};
+    std::vector<brd::board> child_boards;
+    std::vector<std::uint64_t> child_keys;
+    std::vector<std::uint32_t> initial_proof_numbers;
+    child_boards.reserve(moves.size());
+    for (auto move_iterator = moves.begin() ; move_iterator != moves.end() ; move_iterator++) {
+        child_boards.emplace_back(chess_board);
+        make_move(child_boards.back(), *move_iterator);
+        child_keys.push_back(node_key(child_boards.back(), opposition_color, !is_attacker, child_moves_left));
+        // Mates mostly come from checks, so quiet attacking moves start out looking harder to prove
+        bool is_quiet_attack{is_attacker && !is_in_check(child_boards.back(), opposition_color)};
+        initial_proof_numbers.push_back(is_quiet_attack ? quiet_move_proof_number : 1);
+    }
+
+    while (true) {
+        // A node is won as soon as one child is lost for the opposition, and lost only once every child is won
+        std::uint32_t phi{infinite_proof_number};
+        std::uint32_t delta{};
+        std::uint32_t second_smallest_delta{infinite_proof_number};
+        size_t best_child{};
+        std::uint32_t best_child_phi{};
+        for (size_t i{} ; i < child_keys.size() ; i++) {
+            std::uint32_t child_phi{}, child_delta{};
+            if (!lookup(child_keys[i], child_phi, child_delta)) {
+                child_delta = initial_proof_numbers[i];
+            }
+            delta = add_proof_numbers(delta, child_phi);
+            if (child_delta < phi) {
+                second_smallest_delta = phi;
+                phi = child_delta;
+                best_child = i;
+                best_child_phi = child_phi;
+            } else if (child_delta < second_smallest_delta) {
+                second_smallest_delta = child_delta;
+            }
+        }
+
+        if (phi >= phi_threshold || delta >= delta_threshold || nodes_searched >= node_limit) {
+            store(key, phi, delta);
+            return;
+        }
+
+        // Search the most promising child until it is well behind the next best (the 1 + epsilon
+        // trick, which saves switching back and forth between children with similar numbers)
+        std::uint64_t child_phi_threshold{static_cast<std::uint64_t>(delta_threshold) + best_child_phi - delta};
+        std::uint32_t child_delta_threshold{std::min(phi_threshold,
+                                                     std::max(add_proof_numbers(second_smallest_delta, 1),
+                                                              add_proof_numbers(second_smallest_delta, second_smallest_delta/4)))};
+        multiple_iterative_deepening(child_boards[best_child], opposition_color, !is_attacker, child_moves_left,
+                                     static_cast<std::uint32_t>(std::min<std::uint64_t>(child_phi_threshold, infinite_proof_number)),
+                                     child_delta_threshold);
+    }
+}
+
+
+bool eng::mate_solver::attacker_wins(const brd::board& chess_board, pcs::color side_to_move, bool is_attacker, int moves_left) {
+    // Search until the node is proven or disproven, or the node limit is reached
+    multiple_iterative_deepening(chess_board, side_to_move, is_attacker, moves_left, infinite_proof_number, infinite_proof_number);
+    std::uint32_t phi{}, delta{};
+    lookup(node_key(chess_board, side_to_move, is_attacker, moves_left), phi, delta);
+    return is_attacker ? phi == 0 : delta == 0;
+}
+
+
+void eng::mate_solver::build_mating_line(const brd::board& chess_board, pcs::color attacker, int moves_to_mate,
+                                         std::vector<move>& line) {
+    // Attacker plays a move that keeps the mate on schedule, the defender the reply that delays it longest
+    brd::board current_board{chess_board};
+    pcs::color defender{pcs::opposite_color(attacker)};
+    for (int moves_left{moves_to_mate} ; moves_left > 0 ; ) {
+        std::vector<move> attacker_moves{generate_legal_moves(current_board, attacker)};
+        move attacking_move{};
+        for (auto move_iterator = attacker_moves.begin() ; move_iterator != attacker_moves.end() ; move_iterator++) {
+            brd::board board_after_move{current_board};
+            make_move(board_after_move, *move_iterator);
+            if (attacker_wins(board_after_move, defender, false, moves_left - 1)) {
+                attacking_move = *move_iterator;
+                break;
+            }
+        }
+        if (!attacking_move.is_valid()) {
+            return;
+        }
+        line.push_back(attacking_move);
+        make_move(current_board, attacking_move);
+
+        std::vector<move> defending_moves{generate_legal_moves(current_board, defender)};
+        if (defending_moves.empty()) {
+            // Checkmate
+            return;
+        }
+        move defending_move{};
+        int longest_mate{};
+        for (auto move_iterator = defending_moves.begin() ; move_iterator != defending_moves.end() ; move_iterator++) {
+            brd::board board_after_move{current_board};
+            make_move(board_after_move, *move_iterator);
+            int mate_length{1};
+            while (mate_length < moves_left && !attacker_wins(board_after_move, attacker, true, mate_length)) {
+                mate_length++;
+            }
+            if (mate_length > longest_mate) {
+                longest_mate = mate_length;
+                defending_move = *move_iterator;
+            }
+        }
+        line.push_back(defending_move);
+        make_move(current_board, defending_move);
+        moves_left = longest_mate;
+    }
+}
+
+
+eng::mate_result eng::mate_solver::solve(const brd::board& chess_board, pcs::color attacker) {
+    mate_result result{};
+    nodes_searched = 0;
+    node_limit = options.max_nodes;
+
+    // Mates are looked for one move deeper at a time, so the first one found is the shortest
+    for (int moves_to_mate{1} ; moves_to_mate <= options.max_moves ; moves_to_mate++) {
+        if (attacker_wins(chess_board, attacker, true, moves_to_mate)) {
+            result.found = true;
+            result.moves_to_mate = moves_to_mate;
+            break;
+        }
+        if (nodes_searched >= node_limit) {
+            result.node_limit_reached = true;
+            break;
+        }
+    }
+
+    if (result.found) {
+        // Proofs are in the hash table, so finding the line costs a small part of the proof, but it
+        // gets its own node allowance in case some of the proof has been overwritten
+        node_limit = nodes_searched + options.max_nodes;
+        build_mating_line(chess_board, attacker, result.moves_to_mate, result.mating_line);
+    }
+    result.nodes_searched = nodes_searched;
+    return result;
+}
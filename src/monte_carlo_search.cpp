@@ -0,0 +1,218 @@
+// object-oriented-chess-game/monte_carlo_search.cpp
+//
+// Monte Carlo tree search engine mode, using
+// UCT selection and parallel random playouts
+//
+// Author: Jason Dominguez
+
+
+#include <cmath>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include "monte_carlo_search.hpp"
+#include "neural_network.hpp"
+
+
+namespace eng {
+    move choose_playout_move(const brd::board& chess_board, const std::vector<move>& moves, std::mt19937& random_engine) {
+        // Half of the time take the best capture that doesn't lose material, which stops
+        // purely random playouts from leaving pieces hanging, otherwise move at random
+        std::uniform_int_distribution<int> coin_toss(0, 1);
+        if (coin_toss(random_engine) == 1) {
+            move best_capture{};
+            int best_exchange{-1};
+            for (auto move_iterator = moves.begin() ; move_iterator != moves.end() ; move_iterator++) {
+                if (!is_capture(chess_board, *move_iterator)) {
+                    continue;
+                }
+                int exchange{static_exchange_evaluation(chess_board, *move_iterator)};
+                if (exchange > best_exchange) {
+                    best_exchange = exchange;
+                    best_capture = *move_iterator;
+                }
+            }
+            if (best_capture.is_valid()) {
+                return best_capture;
+            }
+        }
+        std::uniform_int_distribution<size_t> move_distribution(0, moves.size() - 1);
+        return moves[move_distribution(random_engine)];
+    }
+}
+
+
+eng::move eng::monte_carlo_search::find_best_move(const brd::board& chess_board, pcs::color side_to_move) {
+    root_board = &chess_board;
+    root.reset(new tree_node);
+    root->side_to_move = side_to_move;
+    root->untried_moves = generate_legal_moves(chess_board, side_to_move);
+    root->moves_generated = true;
+    playouts_completed = 0;
+
+    // Nothing to search when there is at most one legal move
+    if (root->untried_moves.size() <= 1) {
+        return root->untried_moves.empty() ? move{} : root->untried_moves.front();
+    }
+
+    std::shared_ptr<thr::thread_pool> shared_pool{worker_pool ? nullptr : thr::get_shared_thread_pool()};
+    thr::thread_pool& pool{worker_pool ? *worker_pool : *shared_pool};
+    int number_of_threads{options.number_of_threads};
+    if (number_of_threads <= 0) {
+        number_of_threads = static_cast<int>(pool.get_number_of_threads());
+    }
+
+    start_time = std::chrono::steady_clock::now();
+    std::random_device seed_generator;
+    std::vector<std::future<void>> workers;
+    for (int i{} ; i < number_of_threads ; i++) {
+        workers.push_back(pool.submit(std::bind(&monte_carlo_search::run_worker, this, seed_generator())));
+    }
+    for (auto worker_iterator = workers.begin() ; worker_iterator != workers.end() ; worker_iterator++) {
+        pool.wait(*worker_iterator);
+    }
+    root_board = nullptr;
+
+    // Most visited move is the most robust choice
+    move best_move{};
+    long long most_visits{-1};
+    for (auto child_iterator = root->children.begin() ; child_iterator != root->children.end() ; child_iterator++) {
+        if ((*child_iterator)->visits > most_visits) {
+            most_visits = (*child_iterator)->visits;
+            best_move = (*child_iterator)->move_played;
+        }
+    }
+    return best_move;
+}
+
+
+void eng::monte_carlo_search::run_worker(unsigned int seed) {
+    std::mt19937 random_engine{seed};
+    evl::pawn_hash_table pawn_table(1 << 12);
+    std::vector<tree_node*> path;
+
+    while (!budget_exhausted()) {
+        // Selection and expansion, with virtual loss on the path so that other
+        // threads are steered towards different nodes until this playout is back
+        path.clear();
+        bool leaf_needs_moves{};
+        {
+            std::lock_guard<std::mutex> lock{tree_mutex};
+            tree_node* node{root.get()};
+            path.push_back(node);
+            while (node->moves_generated) {
+                if (!node->untried_moves.empty()) {
+                    std::unique_ptr<tree_node> child{new tree_node};
+                    child->move_played = node->untried_moves.back();
+                    child->side_to_move = pcs::opposite_color(node->side_to_move);
+                    child->parent = node;
+                    node->untried_moves.pop_back();
+                    node->children.push_back(std::move(child));
+                    node = node->children.back().get();
+                    node->virtual_losses += options.virtual_loss;
+                    path.push_back(node);
+                    break;
+                }
+                if (node->children.empty()) {
+                    break;
+                }
+                node = select_child(node);
+                node->virtual_losses += options.virtual_loss;
+                path.push_back(node);
+            }
+            leaf_needs_moves = !node->moves_generated;
+        }
+
+        // Replay the path on a copy of the root position
+        brd::board chess_board{*root_board};
+        for (auto node_iterator = path.begin() + 1 ; node_iterator != path.end() ; node_iterator++) {
+            make_move(chess_board, (*node_iterator)->move_played);
+        }
+
+        // Moves for a new node are generated without holding the lock and shuffled
+        // so that expansion order differs between nodes
+        tree_node* leaf{path.back()};
+        if (leaf_needs_moves) {
+            std::vector<move> moves{generate_legal_moves(chess_board, leaf->side_to_move)};
+            std::shuffle(moves.begin(), moves.end(), random_engine);
+            std::lock_guard<std::mutex> lock{tree_mutex};
+            if (!leaf->moves_generated) {
+                leaf->untried_moves = moves;
+                leaf->moves_generated = true;
+            }
+        }
+
+        double white_result{playout(chess_board, leaf->side_to_move, random_engine, pawn_table)};
+
+        // Backpropagation, removing the virtual loss added on the way down
+        {
+            std::lock_guard<std::mutex> lock{tree_mutex};
+            for (auto node_iterator = path.begin() ; node_iterator != path.end() ; node_iterator++) {
+                tree_node* node{*node_iterator};
+                node->visits++;
+                if (node->parent) {
+                    node->virtual_losses -= options.virtual_loss;
+                    node->total_value += node->parent->side_to_move == pcs::white ? white_result : 1.0 - white_result;
+                }
+            }
+        }
+        playouts_completed++;
+    }
+}
+
+
+bool eng::monte_carlo_search::budget_exhausted() {
+    if (playouts_completed >= options.max_playouts) {
+        return true;
+    }
+    auto time_elapsed = std::chrono::steady_clock::now() - start_time;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time_elapsed).count() >= options.time_limit_ms;
+}
+
+
+eng::monte_carlo_search::tree_node* eng::monte_carlo_search::select_child(tree_node* node) {
+    // UCT, with nodes under virtual loss counted as visited and lost
+    double parent_visits{static_cast<double>(node->visits + node->virtual_losses)};
+    double log_parent_visits{std::log(std::max(parent_visits, 1.0))};
+    tree_node* best_child{nullptr};
+    double best_score{-1.0};
+    for (auto child_iterator = node->children.begin() ; child_iterator != node->children.end() ; child_iterator++) {
+        tree_node* child{child_iterator->get()};
+        double child_visits{static_cast<double>(child->visits + child->virtual_losses)};
+        double score{};
+        if (child_visits == 0) {
+            score = 1e9;
+        } else {
+            score = child->total_value/child_visits +
+                    options.exploration_constant*std::sqrt(log_parent_visits/child_visits);
+        }
+        if (score > best_score) {
+            best_score = score;
+            best_child = child;
+        }
+    }
+    return best_child;
+}
+
+
+double eng::monte_carlo_search::playout(brd::board& chess_board, pcs::color side_to_move, std::mt19937& random_engine,
+                                        evl::pawn_hash_table& pawn_table) {
+    // Result is from white's point of view: 1 for a win, 0.5 for a draw and 0 for a loss
+    for (int ply{} ; ply < options.max_playout_length ; ply++) {
+        std::vector<move> moves{generate_legal_moves(chess_board, side_to_move)};
+        if (moves.empty()) {
+            if (!is_in_check(chess_board, side_to_move)) {
+                return 0.5;
+            }
+            return side_to_move == pcs::white ? 0.0 : 1.0;
+        }
+        make_move(chess_board, choose_playout_move(chess_board, moves, random_engine));
+        side_to_move = pcs::opposite_color(side_to_move);
+    }
+
+    // Unfinished playouts are scored by turning the evaluation into an expected result
+    int white_score{nnue::is_network_loaded() ? nnue::evaluate(chess_board, pcs::white)
+                                              : evaluate(chess_board, pcs::white, pawn_table)};
+    return 1.0/(1.0 + std::exp(-white_score/400.0));
+}
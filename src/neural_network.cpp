@@ -0,0 +1,333 @@
+// object-oriented-chess-game/neural_network.cpp
+//
+// Source file for efficiently updatable
+// neural network (NNUE) evaluation
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "neural_network.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NNUE_X86_SIMD
+#endif
+
+
+// Class and function definitions
+namespace nnue {
+    struct network
+    {
+        int hidden_size{};
+        std::vector<std::int16_t> feature_weights;
+        std::vector<std::int16_t> feature_biases;
+        // Stored as int8 in the file but widened once at load time for 16 bit multiply-adds
+        std::vector<std::int16_t> output_weights;
+        std::int32_t output_bias{};
+    };
+
+    std::unique_ptr<network> loaded_network{};
+    int loaded_network_version{-1};
+
+
+    // Scalar versions, used when the CPU has no suitable vector instructions
+    void add_weights_scalar(std::int16_t* values, const std::int16_t* weights, int size) {
+        for (int i{} ; i < size ; i++) {
+            values[i] += weights[i];
+        }
+    }
+
+
+    void subtract_weights_scalar(std::int16_t* values, const std::int16_t* weights, int size) {
+        for (int i{} ; i < size ; i++) {
+            values[i] -= weights[i];
+        }
+    }
+
+
+    std::int32_t clipped_dot_product_scalar(const std::int16_t* values, const std::int16_t* weights, int size) {
+        std::int32_t sum{};
+        for (int i{} ; i < size ; i++) {
+            std::int32_t activation{std::min<std::int32_t>(std::max<std::int32_t>(values[i], 0), activation_clamp)};
+            sum += activation*weights[i];
+        }
+        return sum;
+    }
+
+
+#ifdef NNUE_X86_SIMD
+    __attribute__((target("sse2")))
+    void add_weights_sse2(std::int16_t* values, const std::int16_t* weights, int size) {
+        for (int i{} ; i < size ; i += 8) {
+            __m128i sum{_mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)),
+                                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)))};
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), sum);
+        }
+    }
+
+
+    __attribute__((target("sse2")))
+    void subtract_weights_sse2(std::int16_t* values, const std::int16_t* weights, int size) {
+        for (int i{} ; i < size ; i += 8) {
+            __m128i difference{_mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)))};
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), difference);
+        }
+    }
+
+
+    __attribute__((target("sse2")))
+    std::int32_t clipped_dot_product_sse2(const std::int16_t* values, const std::int16_t* weights, int size) {
+        const __m128i zero{_mm_setzero_si128()};
+        const __m128i clamp{_mm_set1_epi16(activation_clamp)};
+        __m128i sum{_mm_setzero_si128()};
+        for (int i{} ; i < size ; i += 8) {
+            __m128i activation{_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i))};
+            activation = _mm_min_epi16(_mm_max_epi16(activation, zero), clamp);
+            // Pairs of 16 bit products are added into 32 bit lanes
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(activation, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i))));
+        }
+        std::int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+
+    __attribute__((target("avx2")))
+    void add_weights_avx2(std::int16_t* values, const std::int16_t* weights, int size) {
+        for (int i{} ; i < size ; i += 16) {
+            __m256i sum{_mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)),
+                                         _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)))};
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), sum);
+        }
+    }
+
+
+    __attribute__((target("avx2")))
+    void subtract_weights_avx2(std::int16_t* values, const std::int16_t* weights, int size) {
+        for (int i{} ; i < size ; i += 16) {
+            __m256i difference{_mm256_sub_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)),
+                                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)))};
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), difference);
+        }
+    }
+
+
+    __attribute__((target("avx2")))
+    std::int32_t clipped_dot_product_avx2(const std::int16_t* values, const std::int16_t* weights, int size) {
+        const __m256i zero{_mm256_setzero_si256()};
+        const __m256i clamp{_mm256_set1_epi16(activation_clamp)};
+        __m256i sum{_mm256_setzero_si256()};
+        for (int i{} ; i < size ; i += 16) {
+            __m256i activation{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i))};
+            activation = _mm256_min_epi16(_mm256_max_epi16(activation, zero), clamp);
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(activation,
+                                                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i))));
+        }
+        std::int32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+    }
+#endif
+
+
+    simd_level get_simd_level() {
+        // Checked once, the result can't change while the program runs
+        static const simd_level level = []() -> simd_level {
+#ifdef NNUE_X86_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return avx2_instructions;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return sse2_instructions;
+            }
+#endif
+            return scalar_instructions;
+        }();
+        return level;
+    }
+
+
+    std::string simd_level_to_string(simd_level level) {
+        switch (level) {
+            case avx2_instructions:
+                return "AVX2";
+            case sse2_instructions:
+                return "SSE2";
+            default:
+                return "scalar";
+        }
+    }
+
+
+    // Kernels are chosen to match the CPU the first time they are needed
+    struct kernels
+    {
+        void (*add_weights)(std::int16_t*, const std::int16_t*, int){add_weights_scalar};
+        void (*subtract_weights)(std::int16_t*, const std::int16_t*, int){subtract_weights_scalar};
+        std::int32_t (*clipped_dot_product)(const std::int16_t*, const std::int16_t*, int){clipped_dot_product_scalar};
+
+        kernels() {
+#ifdef NNUE_X86_SIMD
+            if (get_simd_level() == avx2_instructions) {
+                add_weights = add_weights_avx2;
+                subtract_weights = subtract_weights_avx2;
+                clipped_dot_product = clipped_dot_product_avx2;
+            } else if (get_simd_level() == sse2_instructions) {
+                add_weights = add_weights_sse2;
+                subtract_weights = subtract_weights_sse2;
+                clipped_dot_product = clipped_dot_product_sse2;
+            }
+#endif
+        }
+    };
+
+
+    const kernels& get_kernels() {
+        static const kernels selected_kernels;
+        return selected_kernels;
+    }
+
+
+    void load_network(std::string file_name) {
+        std::ifstream network_file{file_name, std::ios::binary};
+        if (network_file.fail()) {
+            throw std::ios_base::failure("Network file could not be opened");
+        }
+
+        // Reads raw little endian values straight into the destination
+        auto read_values = [&network_file](void* destination, size_t number_of_bytes) {
+            network_file.read(static_cast<char*>(destination), number_of_bytes);
+            if (static_cast<size_t>(network_file.gcount()) != number_of_bytes) {
+                throw std::runtime_error("Error: Network file is truncated");
+            }
+        };
+
+        char magic[8];
+        read_values(magic, sizeof(magic));
+        if (std::memcmp(magic, "OOCGNNUE", sizeof(magic)) != 0) {
+            throw std::runtime_error("Error: Not a network file");
+        }
+        std::uint32_t version{};
+        std::uint32_t hidden_size{};
+        read_values(&version, sizeof(version));
+        read_values(&hidden_size, sizeof(hidden_size));
+        if (version != network_file_version) {
+            throw std::runtime_error("Error: Unsupported network file version");
+        }
+        // Vector kernels work on 16 values at a time
+        if (hidden_size == 0 || hidden_size%16 != 0 || hidden_size > 4096) {
+            throw std::runtime_error("Error: Invalid network hidden layer size");
+        }
+
+        std::unique_ptr<network> new_network{std::make_unique<network>()};
+        new_network->hidden_size = hidden_size;
+        new_network->feature_weights.resize(number_of_features*hidden_size);
+        new_network->feature_biases.resize(hidden_size);
+        read_values(new_network->feature_weights.data(), new_network->feature_weights.size()*sizeof(std::int16_t));
+        read_values(new_network->feature_biases.data(), new_network->feature_biases.size()*sizeof(std::int16_t));
+
+        std::vector<std::int8_t> output_weights(2*hidden_size);
+        read_values(output_weights.data(), output_weights.size());
+        new_network->output_weights.assign(output_weights.begin(), output_weights.end());
+        read_values(&new_network->output_bias, sizeof(new_network->output_bias));
+
+        loaded_network = std::move(new_network);
+        ++loaded_network_version;
+    }
+
+
+    bool is_network_loaded() {
+        return loaded_network != nullptr;
+    }
+
+
+    int get_network_version() {
+        return loaded_network_version;
+    }
+
+
+    int feature_index(char piece_symbol, pcs::color piece_color, int position, pcs::color perspective) {
+        // Each side sees the board from its own end, with its own pieces first
+        int relative_color{piece_color == perspective ? 0 : 1};
+        int oriented_position{perspective == pcs::white ? position : position ^ 56};
+        int piece_type{};
+        switch (piece_symbol) {
+            case 'p': piece_type = 0; break;
+            case 'N': piece_type = 1; break;
+            case 'B': piece_type = 2; break;
+            case 'R': piece_type = 3; break;
+            case 'Q': piece_type = 4; break;
+            case 'K': piece_type = 5; break;
+            default:
+                throw std::invalid_argument("Invalid chess piece symbol");
+        }
+        return (relative_color*6 + piece_type)*64 + oriented_position;
+    }
+
+
+    void refresh_accumulator(accumulator& piece_accumulator, const brd::board& chess_board) {
+        for (int perspective{} ; perspective < 2 ; perspective++) {
+            piece_accumulator.values[perspective] = loaded_network->feature_biases;
+        }
+        piece_accumulator.network_version = loaded_network_version;
+
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (piece) {
+                update_accumulator(piece_accumulator, piece->get_symbol(), piece->get_piece_color(), i, true);
+            }
+        }
+    }
+
+
+    void update_accumulator(accumulator& piece_accumulator, char piece_symbol, pcs::color piece_color, int position, bool add_piece) {
+        // Only accumulators built for the current network can be updated, any other
+        // accumulator is rebuilt in full when it is next evaluated
+        if (piece_accumulator.network_version != loaded_network_version || !loaded_network) {
+            return;
+        }
+        int hidden_size{loaded_network->hidden_size};
+        const kernels& selected_kernels{get_kernels()};
+        for (int perspective{} ; perspective < 2 ; perspective++) {
+            int feature{feature_index(piece_symbol, piece_color, position, static_cast<pcs::color>(perspective))};
+            const std::int16_t* weights{loaded_network->feature_weights.data() + feature*hidden_size};
+            if (add_piece) {
+                selected_kernels.add_weights(piece_accumulator.values[perspective].data(), weights, hidden_size);
+            } else {
+                selected_kernels.subtract_weights(piece_accumulator.values[perspective].data(), weights, hidden_size);
+            }
+        }
+    }
+
+
+    int evaluate(const brd::board& chess_board, pcs::color side_to_move) {
+        accumulator& piece_accumulator{chess_board.get_accumulator()};
+        if (piece_accumulator.network_version != loaded_network_version) {
+            refresh_accumulator(piece_accumulator, chess_board);
+        }
+
+        // Only the output layer is computed here, the first layer is already in the accumulator
+        int hidden_size{loaded_network->hidden_size};
+        const kernels& selected_kernels{get_kernels()};
+        const std::int16_t* output_weights{loaded_network->output_weights.data()};
+        std::int64_t output{loaded_network->output_bias};
+        output += selected_kernels.clipped_dot_product(piece_accumulator.values[side_to_move].data(),
+                                                       output_weights, hidden_size);
+        output += selected_kernels.clipped_dot_product(piece_accumulator.values[pcs::opposite_color(side_to_move)].data(),
+                                                       output_weights + hidden_size, hidden_size);
+
+        return static_cast<int>(output*output_scale/(activation_clamp*output_weight_scale));
+    }
+}
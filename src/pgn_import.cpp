@@ -0,0 +1,259 @@
+// object-oriented-chess-game/pgn_import.cpp
+//
+// Source file for importing large PGN databases
+// on every core
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <exception>
+#include <ios>
+#include <cstring>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "thread_pool.hpp"
+#include "pgn_reader.hpp"
+#include "san.hpp"
+#include "pgn_import.hpp"
+
+
+// Class and function definitions
+namespace cgm {
+    // Read-only mapping of a whole file, unmapped when it goes out of scope
+    class mapped_file
+    {
+    private:
+        void* mapping{nullptr};
+        size_t mapping_size{};
+
+    public:
+        // Constructors
+        mapped_file(std::string file_name) {
+            int file_descriptor{::open(file_name.c_str(), O_RDONLY)};
+            if (file_descriptor < 0) {
+                throw std::ios_base::failure("File could not be opened");
+            }
+            struct stat file_status;
+            if (fstat(file_descriptor, &file_status) != 0) {
+                ::close(file_descriptor);
+                throw std::ios_base::failure("File could not be read");
+            }
+            mapping_size = static_cast<size_t>(file_status.st_size);
+            if (mapping_size > 0) {
+                mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            }
+            ::close(file_descriptor);
+            if (mapping == MAP_FAILED) {
+                throw std::ios_base::failure("File could not be memory-mapped");
+            }
+            // Every page is read once, front to back
+            if (mapping) {
+                madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+            }
+        }
+        mapped_file(const mapped_file &file_to_copy) = delete;
+        mapped_file& operator=(const mapped_file &file_to_copy) = delete;
+        // Destructor
+        ~mapped_file() {
+            if (mapping) {
+                munmap(mapping, mapping_size);
+            }
+        }
+
+        // Member functions
+        const char* get_text() const { return static_cast<const char*>(mapping); }
+        size_t get_size() const { return mapping_size; }
+    };
+
+
+    bool line_starts_tag_section(const char* text, size_t line_start) {
+        // A tag line whose last non-blank line before it isn't a tag line too (or that begins the file)
+        if (text[line_start] != '[') {
+            return false;
+        }
+        size_t position{line_start};
+        while (position > 0 && std::strchr(" \t\r\n", text[position - 1])) {
+            position--;
+        }
+        if (position == 0) {
+            return true;
+        }
+        while (position > 0 && text[position - 1] != '\n') {
+            position--;
+        }
+        while (text[position] == ' ' || text[position] == '\t') {
+            position++;
+        }
+        return text[position] != '[';
+    }
+
+
+    size_t find_game_start(const char* text, size_t length, size_t from) {
+        // Only lines are looked at, so a tag section inside a multi-line comment would be mistaken for a
+        // game, but real databases don't start comment lines with [
+        size_t line_start{from};
+        while (line_start < length) {
+            if (line_start == 0 || text[line_start - 1] == '\n') {
+                if (line_starts_tag_section(text, line_start)) {
+                    return line_start;
+                }
+            }
+            const void* line_end{std::memchr(text + line_start, '\n', length - line_start)};
+            if (!line_end) {
+                break;
+            }
+            line_start = static_cast<const char*>(line_end) - text + 1;
+        }
+        return length;
+    }
+
+
+    std::vector<imported_game> import_chunk(const char* text, size_t length, bool replay_moves) {
+        std::vector<imported_game> games;
+        size_t game_start{};
+        long long line_number{1};
+        while (game_start < length) {
+            pgn_reader reader{text + game_start, length - game_start, line_number};
+            try {
+                while (true) {
+                    imported_game game{};
+                    if (!reader.read_game(game.game)) {
+                        break;
+                    }
+                    if (replay_moves) {
+                        replay_game(game);
+                    } else {
+                        game.is_valid = true;
+                    }
+                    games.push_back(std::move(game));
+                }
+                break;
+            } catch (const std::exception& e) {
+                // Badly formed text can't be read past reliably, so the game is recorded as invalid and
+                // reading starts again at the next tag section. The reader's lines count from the piece's start
+                imported_game game{};
+                game.error = std::string(e.what()) + " of its part of the file";
+                games.push_back(std::move(game));
+                size_t error_end{game_start + reader.get_characters_read()};
+                game_start = find_game_start(text, length, error_end);
+                line_number = reader.get_line_number() + std::count(text + error_end, text + game_start, '\n');
+            }
+        }
+        return games;
+    }
+
+
+    void replay_game(imported_game& game) {
+        game.replayed_moves.clear();
+        game.is_valid = false;
+        try {
+            std::unique_ptr<brd::board> chess_board;
+            pcs::color side_to_move{pcs::white};
+            std::string fen{game.game.get_tag("FEN")};
+            if (fen.empty()) {
+                chess_board.reset(new brd::board{});
+            } else {
+                std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> position{brd::read_fen(fen)};
+                chess_board.reset(new brd::board{position.first});
+                side_to_move = position.second;
+            }
+            for (auto move_iterator = game.game.moves.begin() ; move_iterator != game.game.moves.end() ; move_iterator++) {
+                eng::move replayed_move{resolve_san(*chess_board, side_to_move, *move_iterator)};
+                eng::make_move(*chess_board, replayed_move);
+                game.replayed_moves.push_back(replayed_move);
+                side_to_move = pcs::opposite_color(side_to_move);
+            }
+            game.is_valid = true;
+        } catch (const std::exception& e) {
+            game.error = "Move " + std::to_string(game.replayed_moves.size() + 1) + ": " + e.what();
+        }
+    }
+
+
+    pgn_import_summary import_pgn_database(std::string file_name, const pgn_import_options& options,
+                                           const std::function<void(const imported_game&)>& game_handler) {
+        auto start_time = std::chrono::steady_clock::now();
+        mapped_file pgn_file{file_name};
+        const char* text{pgn_file.get_text()};
+        size_t length{pgn_file.get_size()};
+        size_t text_start{};
+        // UTF-8 byte order mark some programs put at the start of the file
+        if (length >= 3 && std::memcmp(text, "\xef\xbb\xbf", 3) == 0) {
+            text_start = 3;
+        }
+
+        // Pieces are found before any are imported, which only reads the file near each split
+        std::vector<size_t> chunk_starts{text_start};
+        size_t chunk_size{std::max<size_t>(1, options.chunk_size)};
+        while (chunk_starts.back() + chunk_size < length) {
+            size_t next_start{find_game_start(text, length, chunk_starts.back() + chunk_size)};
+            if (next_start >= length) {
+                break;
+            }
+            chunk_starts.push_back(next_start);
+        }
+        chunk_starts.push_back(length);
+        size_t number_of_chunks{chunk_starts.size() - 1};
+
+        // Each thread takes the next piece when it finishes one. Pieces are handed over by whichever thread
+        // completes the earliest piece still outstanding, so the handler sees the games in file order
+        std::shared_ptr<thr::thread_pool> worker_pool{thr::make_thread_pool(std::max(0, options.number_of_threads))};
+        pgn_import_summary summary{};
+        summary.bytes_read = length;
+        std::vector<std::vector<imported_game>> chunk_games(number_of_chunks);
+        std::vector<bool> is_chunk_done(number_of_chunks, false);
+        std::mutex output_mutex;
+        size_t next_to_hand_over{};
+        std::atomic<size_t> next_chunk{0};
+        size_t number_of_tasks{std::min(worker_pool->get_number_of_threads(), number_of_chunks)};
+        std::vector<std::future<void>> tasks;
+        for (size_t thread{} ; thread < number_of_tasks ; thread++) {
+            tasks.push_back(worker_pool->submit([&]() {
+                for (size_t i{next_chunk++} ; i < number_of_chunks ; i = next_chunk++) {
+                    std::vector<imported_game> games{import_chunk(text + chunk_starts[i], chunk_starts[i + 1] - chunk_starts[i],
+                                                                  options.replay_moves)};
+
+                    std::lock_guard<std::mutex> output_lock{output_mutex};
+                    chunk_games[i] = std::move(games);
+                    is_chunk_done[i] = true;
+                    while (next_to_hand_over < number_of_chunks && is_chunk_done[next_to_hand_over]) {
+                        std::vector<imported_game>& finished_games{chunk_games[next_to_hand_over]};
+                        for (auto game_iterator = finished_games.begin() ; game_iterator != finished_games.end() ; game_iterator++) {
+                            game_iterator->game_number = ++summary.games_imported;
+                            if (game_iterator->is_valid) {
+                                summary.moves_replayed += game_iterator->replayed_moves.size();
+                            } else {
+                                summary.invalid_games++;
+                            }
+                            game_handler(*game_iterator);
+                        }
+                        // Games are kept only until they are handed over
+                        std::vector<imported_game>().swap(finished_games);
+                        next_to_hand_over++;
+                    }
+                }
+            }));
+        }
+        for (auto task_iterator = tasks.begin() ; task_iterator != tasks.end() ; task_iterator++) {
+            worker_pool->wait(*task_iterator);
+        }
+        summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        return summary;
+    }
+}
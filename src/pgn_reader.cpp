@@ -0,0 +1,254 @@
+// object-oriented-chess-game/pgn_reader.cpp
+//
+// Source file for reading games one at a time
+// from portable game notation databases
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <istream>
+#include <fstream>
+#include <memory>
+#include <cstddef>
+#include <ios>
+#include <stdexcept>
+#include <cctype>
+#include "pgn_reader.hpp"
+
+
+// Class and function definitions
+namespace cgm {
+    const int end_of_input{std::char_traits<char>::eof()};
+
+
+    bool is_symbol_character(int character) {
+        // Characters a move, move number or result can contain, as in the PGN standard's symbol tokens
+        return std::isalnum(character) || character == '_' || character == '+' || character == '#' ||
+               character == '=' || character == ':' || character == '-' || character == '/';
+    }
+
+
+    bool is_result(const std::string& token) {
+        return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+    }
+
+
+    std::string pgn_game::get_tag(const std::string& tag_name) const {
+        for (auto tag_iterator = tags.begin() ; tag_iterator != tags.end() ; tag_iterator++) {
+            if (tag_iterator->first == tag_name) {
+                return tag_iterator->second;
+            }
+        }
+        return "";
+    }
+
+
+    void pgn_game::clear() {
+        // Keeps the vectors' storage, so reading game after game into one pgn_game rarely allocates
+        tags.clear();
+        moves.clear();
+        result = "*";
+    }
+}
+
+
+cgm::pgn_reader::pgn_reader(std::string file_name) : pgn_file{new std::ifstream(file_name, std::ios::binary)} {
+    if (pgn_file->fail()) {
+        throw std::ios_base::failure("File could not be opened");
+    }
+    input = pgn_file->rdbuf();
+    // UTF-8 byte order mark some programs put at the start of the file
+    if (peek_character() == 0xef) {
+        next_character();
+        next_character();
+        next_character();
+    }
+}
+
+
+cgm::pgn_reader::pgn_reader(std::istream& pgn_input) : input{pgn_input.rdbuf()} {}
+
+
+cgm::pgn_reader::pgn_reader(const char* text, size_t length) : text_buffer{new memory_buffer(text, length)} {
+    input = text_buffer.get();
+}
+
+
+cgm::pgn_reader::pgn_reader(const char* text, size_t length, long long first_line_number)
+    : text_buffer{new memory_buffer(text, length)}, line_number{first_line_number} {
+    input = text_buffer.get();
+}
+
+
+int cgm::pgn_reader::next_character() {
+    int character{input->sbumpc()};
+    if (character == end_of_input) {
+        return character;
+    }
+    characters_read++;
+    if (character == '\n') {
+        line_number++;
+        is_at_line_start = true;
+    } else {
+        is_at_line_start = false;
+    }
+    return character;
+}
+
+
+int cgm::pgn_reader::peek_character() {
+    return input->sgetc();
+}
+
+
+std::string cgm::pgn_reader::read_token(int first_character) {
+    std::string token(1, static_cast<char>(first_character));
+    // Moves (which start with a letter) may end in e.p., as this program writes en passant captures.
+    // Elsewhere a full stop ends the token, e.g. the move number in 12.Nf3
+    bool is_move{std::isalpha(first_character) != 0};
+    while (is_symbol_character(peek_character()) || (is_move && peek_character() == '.')) {
+        token += static_cast<char>(next_character());
+    }
+    if (is_move && token.size() >= 4 && token.compare(token.size() - 4, 4, "e.p.") == 0) {
+        return token;
+    }
+    while (is_move && token.back() == '.') {
+        token.pop_back();
+    }
+    return token;
+}
+
+
+void cgm::pgn_reader::read_tag(pgn_game& game) {
+    // [Name "Value"], where the value may contain \" and \\ escapes
+    long long tag_line_number{line_number};
+    std::string tag_name;
+    int character{next_character()};
+    while (character == ' ' || character == '\t') {
+        character = next_character();
+    }
+    while (character != end_of_input && is_symbol_character(character)) {
+        tag_name += static_cast<char>(character);
+        character = next_character();
+    }
+    while (character != end_of_input && character != '"' && character != ']' && character != '\n') {
+        character = next_character();
+    }
+    std::string tag_value;
+    if (character == '"') {
+        for (character = next_character() ; character != end_of_input && character != '"' && character != '\n' ;
+             character = next_character()) {
+            if (character == '\\') {
+                character = next_character();
+                if (character == end_of_input) {
+                    break;
+                }
+            }
+            tag_value += static_cast<char>(character);
+        }
+        while (character != end_of_input && character != ']' && character != '\n') {
+            character = next_character();
+        }
+    }
+    if (character != ']') {
+        throw std::invalid_argument("Error: Unterminated tag on line " + std::to_string(tag_line_number));
+    }
+    game.tags.push_back(std::make_pair(tag_name, tag_value));
+}
+
+
+void cgm::pgn_reader::skip_comment() {
+    // Brace comments can run over several lines but can't be nested
+    long long comment_line_number{line_number};
+    for (int character{next_character()} ; character != '}' ; character = next_character()) {
+        if (character == end_of_input) {
+            throw std::invalid_argument("Error: Unterminated comment from line " + std::to_string(comment_line_number));
+        }
+    }
+}
+
+
+void cgm::pgn_reader::skip_rest_of_line() {
+    for (int character{next_character()} ; character != '\n' && character != end_of_input ; character = next_character()) {}
+}
+
+
+bool cgm::pgn_reader::read_game(pgn_game& game) {
+    game.clear();
+    bool has_content{false};
+    int variation_depth{};
+    while (true) {
+        if (is_at_line_start && peek_character() == '%') {
+            // Escaped line, for other programs' use
+            skip_rest_of_line();
+            continue;
+        }
+        if (peek_character() == '[' && !game.moves.empty() && variation_depth == 0) {
+            // Next game's tags, the result was left out. The bracket is left for the next game
+            break;
+        }
+        int character{next_character()};
+        if (character == end_of_input) {
+            // A game cut off before its result is still returned, as unfinished
+            break;
+        }
+        if (std::isspace(character)) {
+            continue;
+        }
+        if (character == '[') {
+            read_tag(game);
+            has_content = true;
+        } else if (character == '{') {
+            skip_comment();
+        } else if (character == ';') {
+            skip_rest_of_line();
+        } else if (character == '(') {
+            variation_depth++;
+        } else if (character == ')') {
+            if (variation_depth > 0) {
+                variation_depth--;
+            }
+        } else if (character == '$') {
+            // Numeric annotation glyph
+            while (std::isdigit(peek_character())) {
+                next_character();
+            }
+        } else if (is_symbol_character(character)) {
+            std::string token{read_token(character)};
+            if (variation_depth > 0) {
+                // Moves in variations aren't part of the game
+                continue;
+            }
+            has_content = true;
+            if (is_result(token)) {
+                game.result = token;
+                games_read++;
+                return true;
+            }
+            if (std::isdigit(static_cast<unsigned char>(token[0])) && token.find_first_not_of("0123456789") == std::string::npos) {
+                // Move number, its full stops are skipped as punctuation
+                continue;
+            }
+            if (token == "e.p." && !game.moves.empty()) {
+                // Written apart from its en passant capture
+                game.moves.back() += token;
+                continue;
+            }
+            game.moves.push_back(token);
+        } else if (character == '*') {
+            if (variation_depth == 0) {
+                games_read++;
+                return true;
+            }
+        }
+        // Anything else, e.g. full stops after move numbers or !? after a move, is punctuation
+    }
+    if (has_content) {
+        games_read++;
+        return true;
+    }
+    return false;
+}
@@ -11,10 +11,16 @@
 #include <iterator>
 #include <utility>
 #include <random>
-#include <chrono>
+#include <iomanip>
+#include <stdexcept>
 #include "player.hpp"
 #include "chess_pieces.hpp"
 #include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "monte_carlo_search.hpp"
+#include "engine_context.hpp"
+#include "opening_book.hpp"
+#include "thread_pool.hpp"
 
 
 // Class and function definitions
@@ -56,9 +62,17 @@ void plr::player::ask_for_color() {
 }
 
 
-std::pair<int, int> plr::human_player::choose_move(const brd::board& chess_board) {
+eng::move plr::human_player::choose_move(const brd::board& chess_board) {
     std::cout << name << "'s turn..." << std::endl;
 
+    // Engine analyses the position for the whole turn, so a hint can be given straight away
+    const int hint_search_depth{8};
+    eng::background_analysis analysis{chess_board, piece_color, hint_search_depth};
+
+    // Every piece's legal moves are found once for the turn, with the pieces checked on the shared pool
+    std::vector<std::pair<int, std::vector<int>>> player_possible_moves{
+        this->get_player_possible_moves(chess_board, *thr::get_shared_thread_pool())};
+
     bool quit_game{false};
     int start_position_index{};
     std::vector<int> possible_final_positions{};
@@ -71,10 +85,18 @@ std::pair<int, int> plr::human_player::choose_move(const brd::board& chess_board
         while (possible_final_positions.size() == 0) {
             do {
                 do {
-                    std::cout << "Please enter the position of the chess piece you want to move (Press 'q' to quit): " ;
+                    std::cout << "Please enter the position of the chess piece you want to move "
+                                 "(Press 'q' to quit, 'h' for a hint): " ;
                     std::string start_position;
                     std::getline(std::cin, start_position);
 
+                    while (start_position == "h" || start_position == "hint") {
+                        give_hint(analysis);
+                        std::cout << "Please enter the position of the chess piece you want to move "
+                                     "(Press 'q' to quit, 'h' for a hint): " ;
+                        std::getline(std::cin, start_position);
+                    }
+
                     if (start_position == "q") {
                         quit_game = true;
                         throw quit_game;
@@ -101,12 +123,14 @@ std::pair<int, int> plr::human_player::choose_move(const brd::board& chess_board
                 }
             } while (chess_board[start_position_index]->get_piece_color() != this->get_piece_color());
 
-            // Get the possible moves for the chosen piece
-            possible_final_positions = chess_board[start_position_index]->get_valid_moves(start_position_index, std::move(chess_board.get_board()));
-            
-            // Account for not moving into check
-            brd::board chess_board_copy{chess_board};
-            possible_moves = this->get_piece_valid_moves(start_position_index, possible_final_positions, std::move(chess_board_copy));
+            // Get the possible moves for the chosen piece, which already account for not moving into check
+            possible_moves = std::pair<int, std::vector<int>>(start_position_index, std::vector<int>{});
+            for (auto moves_iterator = player_possible_moves.begin() ; moves_iterator != player_possible_moves.end() ; moves_iterator++) {
+                if (moves_iterator->first == start_position_index) {
+                    possible_moves = *moves_iterator;
+                }
+            }
+            possible_final_positions = possible_moves.second;
 
             if (possible_moves.second.size() == 0) {
                 std::cout << "Sorry, this piece has no possible moves. Please try again..." << std::endl;
@@ -149,62 +173,231 @@ std::pair<int, int> plr::human_player::choose_move(const brd::board& chess_board
     }
     int end_position_index = brd::board_position_to_index(end_position);
 
-    return std::pair<int, int>(start_position_index, end_position_index);
+    // The promotion piece is asked for once the pawn reaches the last rank
+    return eng::move{start_position_index, end_position_index};
 }
 
 
-std::pair<int, int> plr::chess_bot::choose_move(const brd::board& chess_board) {
-    std::cout << "ChessBot's turn..." << std::endl;
-    std::cout << "Choosing move..." << std::endl;
+void plr::human_player::give_hint(eng::background_analysis& analysis) {
+    std::pair<eng::move, int> best_move_and_score{analysis.get_best_move(hint_latency_ms)};
+    eng::move best_move{best_move_and_score.first};
+    int score{best_move_and_score.second};
+    if (!best_move.is_valid()) {
+        std::cout << "Still thinking... ask again in a moment" << std::endl;
+        return;
+    }
 
-    // Randomly choose one of their color pieces which has 
-    // possible moves and not a blank chess board tile
-    std::vector<std::pair<int, std::vector<int>>> all_possible_moves{};
-    brd::board copy_of_board{chess_board};
-    
-    all_possible_moves = this->get_player_possible_moves(copy_of_board);
+    std::cout << "Hint: move " << brd::board_index_to_position(best_move.start_position) << " to "
+              << brd::board_index_to_position(best_move.end_position) << " (";
+    if (score > eng::checkmate_score - eng::max_mate_ply) {
+        std::cout << "you can checkmate in " << (eng::checkmate_score - score + 1)/2 << " moves";
+    } else if (score < -eng::checkmate_score + eng::max_mate_ply) {
+        std::cout << "you will be checkmated in " << (eng::checkmate_score + score)/2 << " moves";
+    } else {
+        std::cout << "evaluation " << std::showpos << std::fixed << std::setprecision(2) << score/100.0
+                  << std::noshowpos << " pawns";
+    }
+    std::cout << ", depth " << analysis.get_depth() << ")" << std::endl;
+}
 
-    // Select random piece to move, which has valid moves
-    std::default_random_engine engine;
-    engine.seed(std::chrono::system_clock::now().time_since_epoch().count());
-    std::uniform_int_distribution<int> distr(0, all_possible_moves.size() - 1);
-    int random_start_position_index = distr(engine);
 
-    int chosen_start_position = all_possible_moves[random_start_position_index].first;
+eng::move plr::chess_bot::choose_move(const brd::board& chess_board) {
+    if (!is_quiet) {
+        std::cout << "ChessBot's turn..." << std::endl;
+        std::cout << "Choosing move..." << std::endl;
+    }
+    is_last_move_searched = false;
+    ++moves_chosen;
+
+    // Pondering has to finish before this turn's search, its result is kept if the prediction was right
+    stop_pondering();
+    eng::search& engine_search{engine->get_search()};
+    bool is_ponder_hit{ponder_position_hash != 0 && ponder_position_hash == eng::position_hash(chess_board, piece_color) &&
+                       engine_search.get_completed_depth() >= search_depth && ponder_result.first.is_valid()};
+    ponder_position_hash = 0;
+    predicted_reply = eng::move{};
+
+    // Well known opening positions are played straight from the book without searching
+    eng::move best_move{};
+    if (moves_chosen <= random_opening_moves) {
+        std::vector<eng::move> legal_moves{eng::generate_legal_moves(chess_board, piece_color)};
+        if (!legal_moves.empty()) {
+            std::uniform_int_distribution<size_t> move_distribution(0, legal_moves.size() - 1);
+            best_move = legal_moves[move_distribution(random_engine)];
+        }
+    } else if (opening_book) {
+        std::mt19937 random_engine{std::random_device{}()};
+        best_move = opening_book->choose_book_move(chess_board, piece_color, random_engine);
+    }
+
+    if (best_move.is_valid()) {
+        if (!is_quiet) {
+            std::cout << "Playing a book move" << std::endl;
+        }
+    } else if (mode == monte_carlo_tree_search) {
+        // Search for the best move using parallel Monte Carlo playouts
+        best_move = engine->get_tree_search().find_best_move(chess_board, piece_color);
+    } else {
+        if (is_ponder_hit) {
+            // Predicted reply was played, so the search is already done
+            best_move = ponder_result.first;
+            last_score = ponder_result.second;
+        } else {
+            // Search for the best move using alpha-beta search
+            std::pair<eng::move, int> best_move_and_score = engine_search.find_best_move(chess_board, piece_color, search_depth);
+            best_move = best_move_and_score.first;
+            last_score = best_move_and_score.second;
+        }
+        is_last_move_searched = best_move.is_valid();
+
+        // Expected reply is the best move the search stored for the position after this move
+        if (best_move.is_valid()) {
+            brd::board board_after_move{chess_board};
+            eng::make_move(board_after_move, best_move);
+            predicted_reply = engine_search.get_hash_move(board_after_move, pcs::opposite_color(piece_color));
+        }
+    }
+
+    // No legal moves (stalemate), so the game can't continue
+    if (!best_move.is_valid()) {
+        bool quit_game{true};
+        throw quit_game;
+    }
+
+    last_move = best_move;
+    return best_move;
+}
+
+
+void plr::chess_bot::set_random_opening(int number_of_moves, unsigned int seed) {
+    random_opening_moves = number_of_moves;
+    moves_chosen = 0;
+    random_engine.seed(seed);
+}
+
+
+void plr::chess_bot::start_pondering(const brd::board& chess_board) {
+    // Search the position after the predicted reply while the opposition is thinking
+    stop_pondering();
+    if (!predicted_reply.is_valid()) {
+        return;
+    }
+    std::vector<eng::move> opposition_moves{eng::generate_legal_moves(chess_board, pcs::opposite_color(piece_color))};
+    if (std::find(opposition_moves.begin(), opposition_moves.end(), predicted_reply) == opposition_moves.end()) {
+        return;
+    }
+
+    std::shared_ptr<brd::board> ponder_board{std::make_shared<brd::board>(chess_board)};
+    eng::make_move(*ponder_board, predicted_reply);
+    ponder_position_hash = eng::position_hash(*ponder_board, piece_color);
+    ponder_result = std::pair<eng::move, int>{};
+
+    // Searches deeper than a normal turn would, since it is stopped as soon as the opposition moves.
+    // Uses the bot's own search, so even a wrong prediction leaves useful transposition table entries
+    ponder_thread = std::thread([this, ponder_board]() {
+        ponder_result = engine->get_search().find_best_move(*ponder_board, piece_color, search_depth + 2);
+    });
+}
+
+
+void plr::chess_bot::stop_pondering() {
+    if (ponder_thread.joinable()) {
+        engine->get_search().stop();
+        ponder_thread.join();
+        engine->get_search().reset_stop();
+    }
+}
+
+
+void plr::chess_bot::set_engine_context(std::shared_ptr<eng::engine_context> context_to_use) {
+    if (!context_to_use) {
+        throw std::invalid_argument("Engine context must not be null");
+    }
+    stop_pondering();
+    ponder_position_hash = 0;
+    engine = context_to_use;
+}
+
+
+void plr::chess_bot::clear_engine_context() {
+    // Throws away the transposition table, history and caches, e.g. before an unrelated game
+    stop_pondering();
+    ponder_position_hash = 0;
+    predicted_reply = eng::move{};
+    engine->clear();
+}
+
+
+std::vector<eng::analysed_line> plr::chess_bot::get_best_lines(const brd::board& chess_board, pcs::color side_to_move,
+                                                               int number_of_lines) {
+    // Top moves with scores and expected lines, e.g. to grade the moves a human played. Shares the
+    // bot's search, so pondering stops and its predicted position no longer counts as searched
+    stop_pondering();
+    ponder_position_hash = 0;
+    return engine->get_search().find_best_lines(chess_board, side_to_move, search_depth, number_of_lines);
+}
 
-    // Select random move from piece's possible moves
-    std::default_random_engine engine2;
-    engine2.seed(std::chrono::system_clock::now().time_since_epoch().count());
-    std::uniform_int_distribution<int> distr2(0, all_possible_moves[random_start_position_index].second.size() - 1);
-    int random_final_position_index = distr2(engine2);
-    
-    int chosen_final_position = all_possible_moves[random_start_position_index].second[random_final_position_index];
 
-    return std::pair<int, int>(chosen_start_position, chosen_final_position);
+void plr::chess_bot::resize_transposition_table(size_t number_of_entries) {
+    stop_pondering();
+    ponder_position_hash = 0;
+    engine->resize_transposition_table(number_of_entries);
 }
 
 
 std::vector<std::pair<int, std::vector<int>>> plr::player::get_player_possible_moves(const brd::board& original_chess_board) {
     // Get all possible moves for all player's pieces
-    std::vector<std::pair<int, std::vector<int>>> all_possible_moves{};   
+    return filter_possible_moves('\0', original_chess_board, nullptr);
+}
+
+
+std::vector<std::pair<int, std::vector<int>>> plr::player::get_player_possible_moves(const brd::board& original_chess_board,
+                                                                                    thr::thread_pool& worker_pool) {
+    return filter_possible_moves('\0', original_chess_board, &worker_pool);
+}
+
+
+std::vector<std::pair<int, std::vector<int>>> plr::player::filter_possible_moves(char chess_piece,
+                                                                                const brd::board& original_chess_board,
+                                                                                thr::thread_pool* worker_pool) {
+    // Candidate moves are cheap to find, it is checking each one for leaving the king in check that takes the time
+    std::vector<std::pair<int, std::vector<int>>> candidate_moves{};
+    size_t number_of_candidate_moves{};
     for (int i{} ; i < 8*8 ; i++) {
-        // Deep copy original chess board to make temporary moves testing validity
-        brd::board chess_board{original_chess_board};
-        if (chess_board[i] && chess_board[i]->get_piece_color() == this->piece_color) {
-            std::vector<int> possible_final_positions;
-            possible_final_positions = chess_board[i]->get_valid_moves(i, std::move(chess_board.get_board()));
-
-            if (possible_final_positions.size() == 0) {
-                continue;
-            }
+        pcs::chess_piece* piece{original_chess_board.get_piece(i)};
+        if (!piece || piece->get_piece_color() != this->piece_color || (chess_piece && piece->get_symbol() != chess_piece)) {
+            continue;
+        }
+        std::vector<int> possible_final_positions{piece->get_valid_moves(i, original_chess_board.get_board())};
+        if (possible_final_positions.size() > 0) {
+            number_of_candidate_moves += possible_final_positions.size();
+            candidate_moves.push_back(std::pair<int, std::vector<int>>(i, possible_final_positions));
+        }
+    }
 
-            std::pair<int, std::vector<int>> possible_moves = this->get_piece_valid_moves(i, possible_final_positions, 
-                                                                                          std::move(chess_board));
-            
-            // Account for pieces with no possible moves (i.e. king had moves removed and now has none)
-            if (possible_moves.second.size() > 0) {
-                all_possible_moves.push_back(possible_moves);
-            }
+    // Each piece's moves are checked on their own deep copy of the board and kept in their own slot,
+    // so the result is in board order whichever thread finishes first
+    std::vector<std::pair<int, std::vector<int>>> checked_moves(candidate_moves.size());
+    auto check_pieces = [&](size_t begin, size_t end) {
+        for (size_t k{begin} ; k < end ; k++) {
+            brd::board chess_board{original_chess_board};
+            checked_moves[k] = this->get_piece_valid_moves(candidate_moves[k].first, candidate_moves[k].second, chess_board);
+        }
+    };
+    // A handful of moves is checked faster than the tasks could be handed out
+    const size_t min_parallel_candidate_moves{16};
+    if (worker_pool && worker_pool->get_number_of_threads() > 1 && candidate_moves.size() > 1 &&
+        number_of_candidate_moves >= min_parallel_candidate_moves) {
+        worker_pool->parallel_for(candidate_moves.size(), 1, check_pieces);
+    } else {
+        check_pieces(0, candidate_moves.size());
+    }
+
+    // Account for pieces with no possible moves (i.e. king had moves removed and now has none)
+    std::vector<std::pair<int, std::vector<int>>> all_possible_moves{};
+    for (auto moves_iterator = checked_moves.begin() ; moves_iterator != checked_moves.end() ; moves_iterator++) {
+        if (moves_iterator->second.size() > 0) {
+            all_possible_moves.push_back(*moves_iterator);
         }
     }
     return all_possible_moves;
@@ -214,30 +407,7 @@ std::vector<std::pair<int, std::vector<int>>> plr::player::get_player_possible_m
 std::vector<std::pair<int, std::vector<int>>> plr::player::get_player_piece_possible_moves(char chess_piece, 
                                                                                            const brd::board& original_chess_board) {
     // Get all possible moves for all player's specified piece
-    std::vector<std::pair<int, std::vector<int>>> all_possible_moves{};
-    
-    // Deep copy original chess board to make temporary moves testing validity
-    brd::board chess_board{original_chess_board};
-    
-    for (int i{} ; i < 8*8 ; i++) {
-        if (chess_board[i] && chess_board[i]->get_piece_color() == this->piece_color && chess_board[i]->get_symbol() == chess_piece) {
-            std::vector<int> possible_final_positions;
-            possible_final_positions = chess_board[i]->get_valid_moves(i, std::move(chess_board.get_board()));
-
-            if (possible_final_positions.size() == 0) {
-                continue;
-            }
-
-            std::pair<int, std::vector<int>> possible_moves = this->get_piece_valid_moves(i, possible_final_positions, 
-                                                                                          std::move(chess_board));
-
-            // Account for pieces with no possible moves (i.e. king had moves removed and now has none)
-            if (possible_moves.second.size() > 0) {
-                all_possible_moves.push_back(possible_moves);
-            }
-        }
-    }
-    return all_possible_moves;
+    return filter_possible_moves(chess_piece, original_chess_board, nullptr);
 }
 
 
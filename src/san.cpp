@@ -0,0 +1,337 @@
+// object-oriented-chess-game/san.cpp
+//
+// Source file for reading and writing moves in
+// standard algebraic notation
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "san.hpp"
+
+
+// Class and function definitions
+namespace cgm {
+    san_move parse_san(std::string notation, pcs::color side_to_move) {
+        std::string original_notation{notation};
+        while (!notation.empty() && std::string("+#!?").find(notation.back()) != std::string::npos) {
+            notation.pop_back();
+        }
+        if (notation.size() > 4 && notation.compare(notation.size() - 4, 4, "e.p.") == 0) {
+            notation.erase(notation.size() - 4);
+        }
+
+        san_move parsed_move{};
+        int back_rank{side_to_move == pcs::white ? 0 : 7};
+        if (notation == "O-O" || notation == "0-0" || notation == "O-O-O" || notation == "0-0-0") {
+            parsed_move.piece_symbol = 'K';
+            parsed_move.is_castling = true;
+            parsed_move.start_file = 4;
+            parsed_move.start_rank = back_rank;
+            parsed_move.end_position = back_rank*8 + (notation.size() == 3 ? 6 : 2);
+            return parsed_move;
+        }
+
+        if (!notation.empty() && std::string("KQRBN").find(notation[0]) != std::string::npos) {
+            parsed_move.piece_symbol = notation[0];
+            notation.erase(0, 1);
+        }
+        if (!notation.empty() && std::string("QRBN").find(notation.back()) != std::string::npos) {
+            if (parsed_move.piece_symbol != 'p') {
+                throw std::invalid_argument("Error: Invalid move notation " + original_notation);
+            }
+            parsed_move.promotion_symbol = notation.back();
+            notation.pop_back();
+            if (!notation.empty() && notation.back() == '=') {
+                notation.pop_back();
+            }
+        }
+
+        // What is left is the end square, after as much of the starting square as is needed
+        std::string squares;
+        for (auto character_iterator = notation.begin() ; character_iterator != notation.end() ; character_iterator++) {
+            if (*character_iterator != 'x' && *character_iterator != ':' && *character_iterator != '-') {
+                squares += *character_iterator;
+            }
+        }
+        if (squares.size() < 2 || squares.size() > 4) {
+            throw std::invalid_argument("Error: Invalid move notation " + original_notation);
+        }
+        char end_file{squares[squares.size() - 2]};
+        char end_rank{squares[squares.size() - 1]};
+        if (end_file < 'a' || end_file > 'h' || end_rank < '1' || end_rank > '8') {
+            throw std::invalid_argument("Error: Invalid move notation " + original_notation);
+        }
+        parsed_move.end_position = (end_rank - '1')*8 + (end_file - 'a');
+        for (size_t i{} ; i + 2 < squares.size() ; i++) {
+            if (squares[i] >= 'a' && squares[i] <= 'h' && parsed_move.start_file == -1) {
+                parsed_move.start_file = squares[i] - 'a';
+            } else if (squares[i] >= '1' && squares[i] <= '8' && parsed_move.start_rank == -1) {
+                parsed_move.start_rank = squares[i] - '1';
+            } else {
+                throw std::invalid_argument("Error: Invalid move notation " + original_notation);
+            }
+        }
+        return parsed_move;
+    }
+
+
+    bool is_aligned(int first_position, int second_position) {
+        // Same rank, file or diagonal, the only way a piece can stand between a king and an attacker
+        int row_difference{first_position/8 - second_position/8};
+        int col_difference{first_position%8 - second_position%8};
+        return row_difference == 0 || col_difference == 0 || row_difference == col_difference || row_difference == -col_difference;
+    }
+
+
+    std::vector<int> find_pawn_origins(const brd::board& chess_board, pcs::color side_to_move, int end_position) {
+        int forward{side_to_move == pcs::white ? 8 : -8};
+        int behind{end_position - forward};
+        std::vector<int> origins;
+        if (behind < 0 || behind >= 8*8) {
+            return origins;
+        }
+        auto is_own_pawn = [&](int position) {
+            pcs::chess_piece* piece{chess_board.get_piece(position)};
+            return piece && piece->get_symbol() == 'p' && piece->get_piece_color() == side_to_move;
+        };
+
+        pcs::chess_piece* target{chess_board.get_piece(end_position)};
+        if (!target) {
+            // Pushed one square, or two from the pawn's starting rank
+            int starting_rank{side_to_move == pcs::white ? 1 : 6};
+            if (is_own_pawn(behind)) {
+                origins.push_back(behind);
+            } else if (!chess_board.get_piece(behind) && behind - forward >= 0 && behind - forward < 8*8 &&
+                       (behind - forward)/8 == starting_rank && is_own_pawn(behind - forward)) {
+                origins.push_back(behind - forward);
+            }
+        }
+        // Captures, either of the piece on the end square or en passant of the pawn that just passed it
+        pcs::chess_piece* passed_pawn{chess_board.get_piece(behind)};
+        bool is_en_passant{!target && passed_pawn && passed_pawn->get_symbol() == 'p' &&
+                           passed_pawn->get_piece_color() != side_to_move && passed_pawn->is_en_passant_possible()};
+        if ((target && target->get_piece_color() != side_to_move) || is_en_passant) {
+            for (int col_step : {-1, 1}) {
+                int col{end_position%8 + col_step};
+                if (col >= 0 && col < 8 && is_own_pawn(behind/8*8 + col)) {
+                    origins.push_back(behind/8*8 + col);
+                }
+            }
+        }
+        return origins;
+    }
+
+
+    bool can_castle(const brd::board& chess_board, pcs::color side_to_move, const san_move& parsed_move) {
+        // Neither the king nor the rook has moved, the squares between them are empty and the
+        // king doesn't start in, pass through or (checked later, as for any king move) end in check
+        int king_position{parsed_move.start_rank*8 + parsed_move.start_file};
+        bool is_kingside{parsed_move.end_position > king_position};
+        int rook_position{is_kingside ? king_position + 3 : king_position - 4};
+        pcs::chess_piece* king{chess_board.get_piece(king_position)};
+        pcs::chess_piece* rook{chess_board.get_piece(rook_position)};
+        if (!king || king->get_symbol() != 'K' || king->get_piece_color() != side_to_move || king->get_has_moved() ||
+            !rook || rook->get_symbol() != 'R' || rook->get_piece_color() != side_to_move || rook->get_has_moved()) {
+            return false;
+        }
+        for (int i{std::min(king_position, rook_position) + 1} ; i < std::max(king_position, rook_position) ; i++) {
+            if (chess_board.get_piece(i)) {
+                return false;
+            }
+        }
+        pcs::color opposition_color{pcs::opposite_color(side_to_move)};
+        return !chess_board.is_square_attacked(king_position, opposition_color) &&
+               !chess_board.is_square_attacked((king_position + parsed_move.end_position)/2, opposition_color);
+    }
+
+
+    bool leaves_king_safe(const brd::board& chess_board, pcs::color side_to_move, const eng::move& candidate_move,
+                          int king_position, bool in_check) {
+        // Only moves that could leave the king attacked are tried on a copy of the board: king moves, en passant,
+        // any move out of check and moves of pieces in line with their king, which might be pinned
+        int start_position{candidate_move.start_position};
+        int end_position{candidate_move.end_position};
+        pcs::chess_piece* piece{chess_board.get_piece(start_position)};
+        bool is_en_passant{piece && piece->get_symbol() == 'p' && !chess_board.get_piece(end_position) &&
+                           start_position%8 != end_position%8};
+        if (in_check || start_position == king_position || is_en_passant ||
+            (king_position >= 0 && is_aligned(start_position, king_position))) {
+            brd::board board_after_move{chess_board};
+            eng::make_move(board_after_move, candidate_move);
+            return !eng::is_in_check(board_after_move, side_to_move);
+        }
+        return true;
+    }
+
+
+    std::vector<int> find_origins(const brd::board& chess_board, pcs::color side_to_move, san_move& parsed_move,
+                                  const std::string& notation) {
+        int end_position{parsed_move.end_position};
+        pcs::chess_piece* target{chess_board.get_piece(end_position)};
+        if (target && (target->get_piece_color() == side_to_move || target->get_symbol() == 'K')) {
+            throw std::invalid_argument("Error: Illegal move " + notation);
+        }
+
+        // Rather than generating every legal move, look back from the end square for the pieces that could have
+        // made the move: pawns from the squares behind it, anything else from the board's attack lookup
+        std::vector<int> origins;
+        int back_rank{side_to_move == pcs::white ? 0 : 7};
+        if (parsed_move.piece_symbol == 'K' && end_position/8 == back_rank && (end_position%8 == 6 || end_position%8 == 2) &&
+            (parsed_move.start_file == -1 || parsed_move.start_file == 4) && (parsed_move.start_rank == -1 || parsed_move.start_rank == back_rank)) {
+            // Some programs write castling as the king's move, e.g. Kg1, which from e1 can't be anything else
+            pcs::chess_piece* king{chess_board.get_piece(back_rank*8 + 4)};
+            if (king && king->get_symbol() == 'K' && king->get_piece_color() == side_to_move) {
+                parsed_move.is_castling = true;
+                parsed_move.start_file = 4;
+                parsed_move.start_rank = back_rank;
+            }
+        }
+        if (parsed_move.is_castling) {
+            if (can_castle(chess_board, side_to_move, parsed_move)) {
+                origins.push_back(parsed_move.start_rank*8 + parsed_move.start_file);
+            }
+        } else if (parsed_move.piece_symbol == 'p') {
+            origins = find_pawn_origins(chess_board, side_to_move, end_position);
+            bool is_last_rank{end_position/8 == (side_to_move == pcs::white ? 7 : 0)};
+            if (is_last_rank != (parsed_move.promotion_symbol != 0)) {
+                throw std::invalid_argument("Error: Illegal move " + notation);
+            }
+        } else {
+            std::vector<int> attackers{chess_board.get_attackers(end_position, side_to_move, 0)};
+            for (auto attacker_iterator = attackers.begin() ; attacker_iterator != attackers.end() ; attacker_iterator++) {
+                if (chess_board.get_piece(*attacker_iterator)->get_symbol() == parsed_move.piece_symbol) {
+                    origins.push_back(*attacker_iterator);
+                }
+            }
+        }
+
+        return origins;
+    }
+
+
+    eng::move resolve_san(const brd::board& chess_board, pcs::color side_to_move, const std::string& notation) {
+        san_move parsed_move{parse_san(notation, side_to_move)};
+        int end_position{parsed_move.end_position};
+        std::vector<int> origins{find_origins(chess_board, side_to_move, parsed_move, notation)};
+
+        int king_position{chess_board.find_king(side_to_move)};
+        bool in_check{king_position >= 0 && chess_board.is_square_attacked(king_position, pcs::opposite_color(side_to_move))};
+        eng::move resolved_move{};
+        int number_of_matches{};
+        for (auto origin_iterator = origins.begin() ; origin_iterator != origins.end() ; origin_iterator++) {
+            int start_position{*origin_iterator};
+            if ((parsed_move.start_file != -1 && start_position%8 != parsed_move.start_file) ||
+                (parsed_move.start_rank != -1 && start_position/8 != parsed_move.start_rank)) {
+                continue;
+            }
+            eng::move candidate_move{start_position, end_position, parsed_move.promotion_symbol};
+            if (!leaves_king_safe(chess_board, side_to_move, candidate_move, king_position, in_check)) {
+                continue;
+            }
+            resolved_move = candidate_move;
+            number_of_matches++;
+        }
+        if (number_of_matches == 0) {
+            throw std::invalid_argument("Error: Illegal move " + notation);
+        }
+        if (number_of_matches > 1) {
+            throw std::invalid_argument("Error: Ambiguous move " + notation);
+        }
+        return resolved_move;
+    }
+
+
+    bool is_pseudo_legal(const brd::board& chess_board, pcs::color side_to_move, const eng::move& chosen_move) {
+        // The move written with its piece and both squares, e.g. Ng1f3, is looked up as resolve_san would
+        pcs::chess_piece* piece{chess_board.get_piece(chosen_move.start_position)};
+        if (!piece || piece->get_piece_color() != side_to_move ||
+            (chosen_move.promotion_symbol && piece->get_symbol() != 'p')) {
+            return false;
+        }
+        san_move parsed_move{};
+        parsed_move.piece_symbol = piece->get_symbol();
+        parsed_move.start_file = chosen_move.start_position%8;
+        parsed_move.start_rank = chosen_move.start_position/8;
+        parsed_move.end_position = chosen_move.end_position;
+        parsed_move.promotion_symbol = chosen_move.promotion_symbol;
+        std::vector<int> origins;
+        try {
+            origins = find_origins(chess_board, side_to_move, parsed_move, std::string{});
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+        return std::find(origins.begin(), origins.end(), chosen_move.start_position) != origins.end();
+    }
+
+
+    std::string move_to_san(const brd::board& chess_board, pcs::color side_to_move, const eng::move& chosen_move) {
+        int start_position{chosen_move.start_position};
+        int end_position{chosen_move.end_position};
+        pcs::chess_piece* piece{chess_board.get_piece(start_position)};
+        if (!piece || piece->get_piece_color() != side_to_move) {
+            throw std::invalid_argument("Error: Illegal move " + eng::move_to_string(chosen_move));
+        }
+        char piece_symbol{piece->get_symbol()};
+
+        std::string notation;
+        if (piece_symbol == 'K' && (end_position%8 - start_position%8 == 2 || end_position%8 - start_position%8 == -2)) {
+            notation = end_position > start_position ? "O-O" : "O-O-O";
+        } else {
+            bool is_capture{chess_board.get_piece(end_position) || (piece_symbol == 'p' && start_position%8 != end_position%8)};
+            if (piece_symbol == 'p') {
+                if (is_capture) {
+                    notation += static_cast<char>('a' + start_position%8);
+                }
+            } else {
+                notation += piece_symbol;
+                // The file, the rank or both are added when another piece of the same kind could legally move there,
+                // whichever tells them apart
+                int king_position{chess_board.find_king(side_to_move)};
+                bool in_check{king_position >= 0 && chess_board.is_square_attacked(king_position, pcs::opposite_color(side_to_move))};
+                bool is_ambiguous{false};
+                bool shares_file{false};
+                bool shares_rank{false};
+                std::vector<int> attackers{chess_board.get_attackers(end_position, side_to_move, 0)};
+                for (auto attacker_iterator = attackers.begin() ; attacker_iterator != attackers.end() ; attacker_iterator++) {
+                    if (*attacker_iterator == start_position || chess_board.get_piece(*attacker_iterator)->get_symbol() != piece_symbol ||
+                        !leaves_king_safe(chess_board, side_to_move, eng::move{*attacker_iterator, end_position}, king_position, in_check)) {
+                        continue;
+                    }
+                    is_ambiguous = true;
+                    shares_file = shares_file || *attacker_iterator%8 == start_position%8;
+                    shares_rank = shares_rank || *attacker_iterator/8 == start_position/8;
+                }
+                if (is_ambiguous && (!shares_file || shares_rank)) {
+                    notation += static_cast<char>('a' + start_position%8);
+                }
+                if (is_ambiguous && shares_file) {
+                    notation += static_cast<char>('1' + start_position/8);
+                }
+            }
+            if (is_capture) {
+                notation += 'x';
+            }
+            notation += brd::board_index_to_position(end_position);
+            if (chosen_move.promotion_symbol) {
+                notation += '=';
+                notation += chosen_move.promotion_symbol;
+            }
+        }
+
+        brd::board board_after_move{chess_board};
+        eng::make_move(board_after_move, chosen_move);
+        pcs::color opposition_color{pcs::opposite_color(side_to_move)};
+        if (eng::is_in_check(board_after_move, opposition_color)) {
+            // Legal moves are only generated after checks, to tell mate apart
+            notation += eng::generate_legal_moves(board_after_move, opposition_color).empty() ? '#' : '+';
+        }
+        return notation;
+    }
+}
@@ -0,0 +1,185 @@
+// object-oriented-chess-game/self_play.cpp
+//
+// Source file for generating training data from
+// games the chess bot plays against itself
+//
+// Author: Jason Dominguez
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "player.hpp"
+#include "chess_game.hpp"
+#include "engine_context.hpp"
+#include "thread_pool.hpp"
+#include "training_data.hpp"
+#include "self_play.hpp"
+
+
+// Class and function definitions
+namespace trn {
+    struct self_play_game
+    {
+        std::vector<position_record> records;
+        // For white: 0 loss, 1 draw, 2 win
+        int result{1};
+    };
+
+
+    bool has_insufficient_material(const brd::board& chess_board) {
+        // Bare kings, or kings and a single bishop or knight, can't mate
+        int minor_pieces{};
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (!piece || piece->get_symbol() == 'K') {
+                continue;
+            }
+            if (piece->get_symbol() != 'N' && piece->get_symbol() != 'B') {
+                return false;
+            }
+            minor_pieces++;
+        }
+        return minor_pieces <= 1;
+    }
+
+
+    self_play_game play_self_play_game(const self_play_options& options, std::shared_ptr<plr::chess_bot> white_bot,
+                                       std::shared_ptr<plr::chess_bot> black_bot, unsigned int seed) {
+        // The game is played exactly as main plays one, except that a headless game never prints or asks anything
+        std::shared_ptr<plr::chess_bot> bots[2]{white_bot, black_bot};
+        for (int i{} ; i < 2 ; i++) {
+            bots[i]->set_random_opening(options.random_opening_moves, seed + i);
+        }
+        cgm::chess_game game(bots[0], bots[1], true);
+
+        self_play_game played_game{};
+        std::vector<std::uint64_t> position_hashes;
+        int plies_since_capture_or_pawn_move{};
+        int plies_played{};
+        while (!game.has_ended()) {
+            std::shared_ptr<plr::chess_bot> bot{game.get_current_player() == bots[0] ? bots[0] : bots[1]};
+            pcs::color side_to_move{bot->get_piece_color()};
+            brd::board position_before_move{game.get_chess_board()};
+
+            // The bot only gives up when it has no legal moves, and checkmate has already ended the game
+            if (game.current_player_make_a_move(game.get_game_status() == cgm::check)) {
+                game.declare_draw();
+                break;
+            }
+            game.promote_pawn_if_possible();
+            game.update_game_status();
+            game.get_next_player_ready();
+            plies_played++;
+
+            // Random and book moves have no score, so only searched positions are kept
+            if (bot->get_is_last_move_searched()) {
+                int score{side_to_move == pcs::white ? bot->get_last_score() : -bot->get_last_score()};
+                played_game.records.push_back(make_record(position_before_move, side_to_move, 1, score));
+            }
+            if (game.has_ended()) {
+                break;
+            }
+
+            // Draws the game itself doesn't recognise
+            eng::move last_move{bot->get_last_move()};
+            pcs::chess_piece* moved_piece{position_before_move.get_piece(last_move.start_position)};
+            if (position_before_move.get_piece(last_move.end_position) || (moved_piece && moved_piece->get_symbol() == 'p')) {
+                plies_since_capture_or_pawn_move = 0;
+                position_hashes.clear();
+            } else {
+                plies_since_capture_or_pawn_move++;
+            }
+            brd::board position_after_move{game.get_chess_board()};
+            position_hashes.push_back(eng::position_hash(position_after_move, pcs::opposite_color(side_to_move)));
+            int repetitions{static_cast<int>(std::count(position_hashes.begin(), position_hashes.end(), position_hashes.back()))};
+            if (repetitions >= 3 || plies_since_capture_or_pawn_move >= 100 || plies_played >= 2*options.max_moves ||
+                has_insufficient_material(position_after_move)) {
+                game.declare_draw();
+            }
+        }
+
+        // The player left to move after checkmate is the one who lost
+        if (game.get_game_status() == cgm::checkmate) {
+            played_game.result = game.get_current_player()->get_piece_color() == pcs::white ? 0 : 2;
+        }
+        for (auto record_iterator = played_game.records.begin() ; record_iterator != played_game.records.end() ;
+             record_iterator++) {
+            record_iterator->result = static_cast<std::uint8_t>(played_game.result);
+        }
+        game.game_over();
+        return played_game;
+    }
+
+
+    self_play_summary generate_self_play_data(std::string file_name, const self_play_options& options) {
+        training_data_writer writer{file_name, true};
+        std::shared_ptr<thr::thread_pool> worker_pool{thr::make_thread_pool(std::max(0, options.number_of_threads))};
+        unsigned int seed{options.seed != 0 ? options.seed : std::random_device{}()};
+
+        // Each thread keeps one pair of bots, sharing one engine, for all of its games and takes the next
+        // game number when it finishes one. Whole games are written at once, so the file never holds half a game
+        self_play_summary summary{};
+        std::mutex summary_mutex;
+        std::atomic<int> next_game{0};
+        int progress_interval{std::max(1, options.number_of_games/20)};
+        auto start_time = std::chrono::steady_clock::now();
+        std::vector<std::future<void>> tasks;
+        for (size_t thread{} ; thread < worker_pool->get_number_of_threads() ; thread++) {
+            tasks.push_back(worker_pool->submit([&]() {
+                std::shared_ptr<eng::engine_context> engine{
+                    std::make_shared<eng::engine_context>(options.transposition_table_entries, 0)};
+                std::shared_ptr<plr::chess_bot> white_bot{std::make_shared<plr::chess_bot>(pcs::white, options.search_depth)};
+                std::shared_ptr<plr::chess_bot> black_bot{std::make_shared<plr::chess_bot>(pcs::black, options.search_depth)};
+                for (plr::chess_bot* bot : {white_bot.get(), black_bot.get()}) {
+                    bot->set_quiet(true);
+                    bot->set_engine_context(engine);
+                    bot->set_opening_book(options.opening_book);
+                }
+                for (int game_number{next_game++} ; game_number < options.number_of_games ; game_number = next_game++) {
+                    self_play_game played_game{play_self_play_game(options, white_bot, black_bot, seed + 2*game_number)};
+
+                    std::lock_guard<std::mutex> summary_lock{summary_mutex};
+                    for (auto record_iterator = played_game.records.begin() ; record_iterator != played_game.records.end() ;
+                         record_iterator++) {
+                        writer.write(*record_iterator);
+                    }
+                    writer.flush();
+                    summary.games_played++;
+                    summary.positions_written += played_game.records.size();
+                    if (played_game.result == 2) {
+                        summary.white_wins++;
+                    } else if (played_game.result == 0) {
+                        summary.black_wins++;
+                    } else {
+                        summary.draws++;
+                    }
+                    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                    if (summary.games_played%progress_interval == 0) {
+                        std::cout << "Game " << summary.games_played << "/" << options.number_of_games << ": "
+                                  << summary.positions_written << " positions, "
+                                  << static_cast<long long>(summary.positions_written*3600.0/summary.seconds)
+                                  << " positions/hour" << std::endl;
+                    }
+                }
+            }));
+        }
+        for (auto task_iterator = tasks.begin() ; task_iterator != tasks.end() ; task_iterator++) {
+            worker_pool->wait(*task_iterator);
+        }
+        writer.close();
+        summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        return summary;
+    }
+}
@@ -0,0 +1,637 @@
+// object-oriented-chess-game/tablebase.cpp
+//
+// Source file for endgame tablebase generation
+// (retrograde analysis) and probing
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "tablebase.hpp"
+#include "thread_pool.hpp"
+
+
+// Class and function definitions
+namespace egtb {
+    // Position inside a table with the strong side always playing white: strong king,
+    // weak king and then the strong side's other pieces
+    struct table_position
+    {
+        int squares[4]{};
+        bool strong_to_move{};
+    };
+
+
+    class table
+    {
+    private:
+        // Strong king is kept in the a1-d1-d4 triangle without pawns, the pawn on the a-d files with one
+        std::size_t lead_slot(int square) const;
+        int lead_square(std::size_t slot) const;
+        int lead_piece() const { return has_pawn ? 2 : 0; }
+
+    public:
+        std::string name;
+        // Strong side's pieces other than the king, in table order
+        std::string piece_symbols;
+        bool has_pawn{};
+        int number_of_pieces{};
+        std::size_t size{};
+        std::vector<std::uint8_t> values;
+
+        // Constructors
+        table(std::string table_name, std::string symbols);
+        // Destructor
+        ~table(){}
+
+        // Member functions
+        char get_symbol(int piece) const { return piece == 0 || piece == 1 ? 'K' : piece_symbols[piece - 2]; }
+        std::size_t raw_index(const table_position& position) const;
+        std::size_t canonical_index(const table_position& position) const;
+        table_position decode(std::size_t index) const;
+        bool is_legal(const table_position& position) const;
+        bool is_attacked_by_strong(const table_position& position, int target, int ignored_piece) const;
+        int get_weak_moves(const table_position& position, std::vector<std::size_t>& children, bool& has_escape) const;
+        void get_strong_unmoves(const table_position& position, std::vector<std::size_t>& parents) const;
+        void get_weak_unmoves(const table_position& position, std::vector<std::size_t>& parents) const;
+        void generate(const std::vector<const table*>& promotion_tables);
+        void save(std::string file_name) const;
+        bool load(std::string file_name);
+    };
+
+
+    std::vector<std::unique_ptr<table>> loaded_tables{};
+    const int triangle_squares[10]{0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+    const std::size_t invalid_slot{static_cast<std::size_t>(-1)};
+    const std::uint8_t never_lost{255};
+
+
+    int row(int square) { return square/8; }
+    int col(int square) { return square%8; }
+
+
+    bool are_adjacent(int first_square, int second_square) {
+        return std::abs(row(first_square) - row(second_square)) <= 1 && std::abs(col(first_square) - col(second_square)) <= 1;
+    }
+
+
+    int transform_square(int square, int symmetry) {
+        // Bit 0 mirrors the files, bit 1 the ranks and bit 2 the long diagonal
+        int square_row{row(square)}, square_col{col(square)};
+        if (symmetry & 1) { square_col = 7 - square_col; }
+        if (symmetry & 2) { square_row = 7 - square_row; }
+        if (symmetry & 4) { std::swap(square_row, square_col); }
+        return square_row*8 + square_col;
+    }
+
+
+    void parallel_for(std::size_t number_of_items, const std::function<void(std::size_t, std::size_t)>& work) {
+        // Items are handed out in chunks so threads that finish early pick up more work
+        std::shared_ptr<thr::thread_pool> worker_pool{thr::get_shared_thread_pool()};
+        std::size_t chunk_size{std::max<std::size_t>(1024, number_of_items/(64*worker_pool->get_number_of_threads()) + 1)};
+        worker_pool->parallel_for(number_of_items, chunk_size, work);
+    }
+
+
+    table* find_table(std::string symbols) {
+        std::sort(symbols.begin(), symbols.end());
+        for (auto table_iterator = loaded_tables.begin() ; table_iterator != loaded_tables.end() ; table_iterator++) {
+            std::string table_symbols{(*table_iterator)->piece_symbols};
+            std::sort(table_symbols.begin(), table_symbols.end());
+            if (table_symbols == symbols) {
+                return table_iterator->get();
+            }
+        }
+        return nullptr;
+    }
+}
+
+
+egtb::table::table(std::string table_name, std::string symbols) : name{table_name}, piece_symbols{symbols} {
+    has_pawn = piece_symbols.find('p') != std::string::npos;
+    number_of_pieces = 2 + static_cast<int>(piece_symbols.size());
+    size = (has_pawn ? 32 : 10)*2;
+    for (int i{1} ; i < number_of_pieces ; i++) {
+        size *= 64;
+    }
+}
+
+
+std::size_t egtb::table::lead_slot(int square) const {
+    if (has_pawn) {
+        return col(square) < 4 ? row(square)*4 + col(square) : invalid_slot;
+    }
+    const int* triangle_square{std::find(triangle_squares, triangle_squares + 10, square)};
+    return triangle_square != triangle_squares + 10 ? triangle_square - triangle_squares : invalid_slot;
+}
+
+
+int egtb::table::lead_square(std::size_t slot) const {
+    return has_pawn ? static_cast<int>((slot/4)*8 + slot%4) : triangle_squares[slot];
+}
+
+
+std::size_t egtb::table::raw_index(const table_position& position) const {
+    std::size_t index{lead_slot(position.squares[lead_piece()])};
+    for (int i{} ; i < number_of_pieces ; i++) {
+        if (i != lead_piece()) {
+            index = index*64 + position.squares[i];
+        }
+    }
+    return index*2 + (position.strong_to_move ? 0 : 1);
+}
+
+
+std::size_t egtb::table::canonical_index(const table_position& position) const {
+    // Symmetrical positions share the smallest index among them, so each is only solved once
+    std::size_t best_index{invalid_slot};
+    int number_of_symmetries{has_pawn ? 2 : 8};
+    for (int symmetry{} ; symmetry < number_of_symmetries ; symmetry++) {
+        table_position transformed_position{position};
+        for (int i{} ; i < number_of_pieces ; i++) {
+            transformed_position.squares[i] = transform_square(position.squares[i], symmetry);
+        }
+        if (lead_slot(transformed_position.squares[lead_piece()]) != invalid_slot) {
+            best_index = std::min(best_index, raw_index(transformed_position));
+        }
+    }
+    return best_index;
+}
+
+
+egtb::table_position egtb::table::decode(std::size_t index) const {
+    table_position position{};
+    position.strong_to_move = index%2 == 0;
+    index /= 2;
+    for (int i{number_of_pieces - 1} ; i >= 0 ; i--) {
+        if (i != lead_piece()) {
+            position.squares[i] = static_cast<int>(index%64);
+            index /= 64;
+        }
+    }
+    position.squares[lead_piece()] = lead_square(index);
+    return position;
+}
+
+
+bool egtb::table::is_legal(const table_position& position) const {
+    for (int i{} ; i < number_of_pieces ; i++) {
+        for (int j{i + 1} ; j < number_of_pieces ; j++) {
+            if (position.squares[i] == position.squares[j]) {
+                return false;
+            }
+        }
+        if (get_symbol(i) == 'p' && (row(position.squares[i]) == 0 || row(position.squares[i]) == 7)) {
+            return false;
+        }
+    }
+    if (are_adjacent(position.squares[0], position.squares[1])) {
+        return false;
+    }
+    // Weak king can't be in check with the strong side to move
+    return !position.strong_to_move || !is_attacked_by_strong(position, position.squares[1], -1);
+}
+
+
+bool egtb::table::is_attacked_by_strong(const table_position& position, int target, int ignored_piece) const {
+    // Weak king is left out of the blockers, since it can't hide behind itself when moving along a line
+    auto is_blocked = [&](int square) {
+        for (int i{} ; i < number_of_pieces ; i++) {
+            if (i != 1 && i != ignored_piece && position.squares[i] == square) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (int i{} ; i < number_of_pieces ; i++) {
+        if (i == 1 || i == ignored_piece || position.squares[i] == target) {
+            continue;
+        }
+        int start{position.squares[i]};
+        int row_difference{row(target) - row(start)}, col_difference{col(target) - col(start)};
+        int row_distance{std::abs(row_difference)}, col_distance{std::abs(col_difference)};
+        char symbol{get_symbol(i)};
+        bool is_straight{row_distance == 0 || col_distance == 0};
+        bool is_diagonal{row_distance == col_distance};
+
+        if (symbol == 'K') {
+            if (row_distance <= 1 && col_distance <= 1) { return true; }
+        } else if (symbol == 'N') {
+            if ((row_distance == 1 && col_distance == 2) || (row_distance == 2 && col_distance == 1)) { return true; }
+        } else if (symbol == 'p') {
+            if (row_difference == 1 && col_distance == 1) { return true; }
+        } else if ((symbol == 'R' && is_straight) || (symbol == 'B' && is_diagonal) ||
+                   (symbol == 'Q' && (is_straight || is_diagonal))) {
+            int step{(row_difference > 0) - (row_difference < 0)};
+            step = step*8 + (col_difference > 0) - (col_difference < 0);
+            int square{start + step};
+            while (square != target && !is_blocked(square)) {
+                square += step;
+            }
+            if (square == target) { return true; }
+        }
+    }
+    return false;
+}
+
+
+int egtb::table::get_weak_moves(const table_position& position, std::vector<std::size_t>& children, bool& has_escape) const {
+    // Lone king moves, where capturing a piece escapes into a drawn ending
+    int number_of_moves{};
+    int start{position.squares[1]};
+    for (int row_step{-1} ; row_step <= 1 ; row_step++) {
+        for (int col_step{-1} ; col_step <= 1 ; col_step++) {
+            int end_row{row(start) + row_step}, end_col{col(start) + col_step};
+            if ((row_step == 0 && col_step == 0) || end_row < 0 || end_row >= 8 || end_col < 0 || end_col >= 8) {
+                continue;
+            }
+            int end{end_row*8 + end_col};
+            if (are_adjacent(end, position.squares[0])) {
+                continue;
+            }
+            int captured_piece{-1};
+            for (int i{2} ; i < number_of_pieces ; i++) {
+                if (position.squares[i] == end) {
+                    captured_piece = i;
+                }
+            }
+            if (is_attacked_by_strong(position, end, captured_piece)) {
+                continue;
+            }
+            number_of_moves++;
+            if (captured_piece >= 0) {
+                has_escape = true;
+            } else {
+                table_position child{position};
+                child.squares[1] = end;
+                child.strong_to_move = true;
+                children.push_back(canonical_index(child));
+            }
+        }
+    }
+    return number_of_moves;
+}
+
+
+void egtb::table::get_strong_unmoves(const table_position& position, std::vector<std::size_t>& parents) const {
+    // Squares each strong piece could have come from; the weak side has nothing to capture
+    // so every strong move is a quiet move
+    auto is_empty = [&](int square) {
+        for (int i{} ; i < number_of_pieces ; i++) {
+            if (position.squares[i] == square) {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto add_parent = [&](int piece, int start) {
+        table_position parent{position};
+        parent.squares[piece] = start;
+        parent.strong_to_move = true;
+        if (is_legal(parent)) {
+            parents.push_back(canonical_index(parent));
+        }
+    };
+
+    const int knight_steps[8][2]{{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    const int line_steps[8][2]{{0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+    for (int i{} ; i < number_of_pieces ; i++) {
+        if (i == 1) {
+            continue;
+        }
+        int end{position.squares[i]};
+        char symbol{get_symbol(i)};
+        if (symbol == 'p') {
+            if (row(end) >= 2 && is_empty(end - 8)) {
+                add_parent(i, end - 8);
+                if (row(end) == 3 && is_empty(end - 16)) {
+                    add_parent(i, end - 16);
+                }
+            }
+        } else if (symbol == 'K' || symbol == 'N') {
+            for (int j{} ; j < 8 ; j++) {
+                int start_row{row(end) + (symbol == 'K' ? line_steps[j][0] : knight_steps[j][0])};
+                int start_col{col(end) + (symbol == 'K' ? line_steps[j][1] : knight_steps[j][1])};
+                if (start_row >= 0 && start_row < 8 && start_col >= 0 && start_col < 8 && is_empty(start_row*8 + start_col)) {
+                    add_parent(i, start_row*8 + start_col);
+                }
+            }
+        } else {
+            int first_direction{symbol == 'B' ? 4 : 0};
+            int last_direction{symbol == 'R' ? 4 : 8};
+            for (int j{first_direction} ; j < last_direction ; j++) {
+                int start_row{row(end) + line_steps[j][0]}, start_col{col(end) + line_steps[j][1]};
+                while (start_row >= 0 && start_row < 8 && start_col >= 0 && start_col < 8 && is_empty(start_row*8 + start_col)) {
+                    add_parent(i, start_row*8 + start_col);
+                    start_row += line_steps[j][0];
+                    start_col += line_steps[j][1];
+                }
+            }
+        }
+    }
+}
+
+
+void egtb::table::get_weak_unmoves(const table_position& position, std::vector<std::size_t>& parents) const {
+    int end{position.squares[1]};
+    for (int row_step{-1} ; row_step <= 1 ; row_step++) {
+        for (int col_step{-1} ; col_step <= 1 ; col_step++) {
+            int start_row{row(end) + row_step}, start_col{col(end) + col_step};
+            if ((row_step == 0 && col_step == 0) || start_row < 0 || start_row >= 8 || start_col < 0 || start_col >= 8) {
+                continue;
+            }
+            table_position parent{position};
+            parent.squares[1] = start_row*8 + start_col;
+            parent.strong_to_move = false;
+            if (is_legal(parent)) {
+                parents.push_back(canonical_index(parent));
+            }
+        }
+    }
+}
+
+
+void egtb::table::generate(const std::vector<const table*>& promotion_tables) {
+    // Retrograde analysis: starting from the checkmates, positions are solved one ply at a time.
+    // A strong side position is won as soon as one move reaches a lost position, a weak side
+    // position is lost once every one of its (symmetry distinct) moves reaches a won position
+    std::vector<std::atomic<std::uint8_t>> results(size);
+    std::vector<std::atomic<std::uint8_t>> remaining_moves(size);
+    std::vector<std::uint8_t> promotion_results(has_pawn ? size : 0);
+    std::atomic<int> last_promotion_result{0};
+
+    parallel_for(size, [&](std::size_t begin, std::size_t end) {
+        std::vector<std::size_t> children;
+        for (std::size_t index{begin} ; index < end ; index++) {
+            table_position position{decode(index)};
+            if (!is_legal(position) || canonical_index(position) != index) {
+                results[index] = unused_value;
+                continue;
+            }
+
+            if (!position.strong_to_move) {
+                children.clear();
+                bool has_escape{false};
+                int number_of_moves{get_weak_moves(position, children, has_escape)};
+                std::sort(children.begin(), children.end());
+                children.erase(std::unique(children.begin(), children.end()), children.end());
+                if (number_of_moves == 0) {
+                    // Checkmate, or stalemate which stays a draw
+                    results[index] = is_attacked_by_strong(position, position.squares[1], -1) ? 1 : draw_value;
+                    remaining_moves[index] = never_lost;
+                } else {
+                    remaining_moves[index] = has_escape ? never_lost : static_cast<std::uint8_t>(children.size());
+                }
+            } else if (has_pawn) {
+                // Promotions leave this table, so their results come from the queen and rook tables
+                int pawn_square{position.squares[2]};
+                bool pawn_can_promote{row(pawn_square) == 6 && pawn_square + 8 != position.squares[0] &&
+                                      pawn_square + 8 != position.squares[1]};
+                if (!pawn_can_promote) {
+                    continue;
+                }
+                std::uint8_t best_result{};
+                for (auto table_iterator = promotion_tables.begin() ; table_iterator != promotion_tables.end() ; table_iterator++) {
+                    table_position promoted_position{position};
+                    promoted_position.squares[2] = pawn_square + 8;
+                    promoted_position.strong_to_move = false;
+                    std::uint8_t promoted_value{(*table_iterator)->values[(*table_iterator)->canonical_index(promoted_position)]};
+                    if (promoted_value != draw_value && promoted_value != unused_value &&
+                        (best_result == 0 || promoted_value + 1 < best_result)) {
+                        best_result = promoted_value + 1;
+                    }
+                }
+                promotion_results[index] = best_result;
+                int previous_last{last_promotion_result};
+                while (best_result > previous_last && !last_promotion_result.compare_exchange_weak(previous_last, best_result)) {}
+            }
+        }
+    });
+
+    // Values are plies to mate plus one, so odd values are lost weak side positions
+    // and even values won strong side positions
+    for (int level{1} ; level < unused_value - 1 ; level++) {
+        std::atomic<long long> positions_solved{0};
+        parallel_for(size, [&](std::size_t begin, std::size_t end) {
+            std::vector<std::size_t> parents;
+            for (std::size_t index{begin} ; index < end ; index++) {
+                if (has_pawn && promotion_results[index] == level + 1) {
+                    std::uint8_t unsolved{draw_value};
+                    if (results[index].compare_exchange_strong(unsolved, static_cast<std::uint8_t>(level + 1))) {
+                        positions_solved++;
+                    }
+                }
+                if (results[index] != level) {
+                    continue;
+                }
+
+                parents.clear();
+                table_position position{decode(index)};
+                if (level%2 == 1) {
+                    get_strong_unmoves(position, parents);
+                } else {
+                    get_weak_unmoves(position, parents);
+                }
+                std::sort(parents.begin(), parents.end());
+                parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+
+                for (auto parent_iterator = parents.begin() ; parent_iterator != parents.end() ; parent_iterator++) {
+                    std::size_t parent{*parent_iterator};
+                    if (results[parent] != draw_value) {
+                        continue;
+                    }
+                    if (level%2 == 1) {
+                        std::uint8_t unsolved{draw_value};
+                        if (results[parent].compare_exchange_strong(unsolved, static_cast<std::uint8_t>(level + 1))) {
+                            positions_solved++;
+                        }
+                    } else if (remaining_moves[parent] != never_lost && remaining_moves[parent].fetch_sub(1) == 1) {
+                        results[parent] = static_cast<std::uint8_t>(level + 1);
+                        positions_solved++;
+                    }
+                }
+            }
+        });
+        if (positions_solved == 0 && level >= last_promotion_result) {
+            break;
+        }
+    }
+
+    values.resize(size);
+    for (std::size_t i{} ; i < size ; i++) {
+        values[i] = results[i];
+    }
+}
+
+
+void egtb::table::save(std::string file_name) const {
+    std::ofstream table_file{file_name, std::ios::binary};
+    if (table_file.fail()) {
+        throw std::ios_base::failure("Tablebase file could not be written");
+    }
+    std::uint64_t table_size{size};
+    table_file.write("OOCGEGTB", 8);
+    table_file.write(reinterpret_cast<const char*>(&tablebase_file_version), sizeof(tablebase_file_version));
+    table_file.write(reinterpret_cast<const char*>(&table_size), sizeof(table_size));
+    table_file.write(reinterpret_cast<const char*>(values.data()), values.size());
+}
+
+
+bool egtb::table::load(std::string file_name) {
+    std::ifstream table_file{file_name, std::ios::binary};
+    if (table_file.fail()) {
+        return false;
+    }
+    char magic[8]{};
+    std::uint32_t version{};
+    std::uint64_t table_size{};
+    table_file.read(magic, 8);
+    table_file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    table_file.read(reinterpret_cast<char*>(&table_size), sizeof(table_size));
+    if (table_file.fail() || std::memcmp(magic, "OOCGEGTB", 8) != 0 || version != tablebase_file_version || table_size != size) {
+        return false;
+    }
+    values.resize(size);
+    table_file.read(reinterpret_cast<char*>(values.data()), size);
+    if (static_cast<std::size_t>(table_file.gcount()) != size) {
+        values.clear();
+        return false;
+    }
+    return true;
+}
+
+
+namespace egtb {
+    void generate_tablebases() {
+        generate_tablebases("");
+    }
+
+
+    void generate_tablebases(std::string directory) {
+        // Tables are loaded from the directory if already there, otherwise generated (and saved
+        // when a directory is given). Pawn table promotes into the queen and rook tables,
+        // so those are done first
+        loaded_tables.clear();
+        const std::string table_names[4]{"KQK", "KRK", "KPK", "KBNK"};
+        const std::string table_symbols[4]{"Q", "R", "p", "BN"};
+        for (int i{} ; i < 4 ; i++) {
+            std::unique_ptr<table> new_table{new table(table_names[i], table_symbols[i])};
+            std::string file_name{directory.empty() ? "" : directory + "/" + table_names[i] + ".egtb"};
+            if (file_name.empty() || !new_table->load(file_name)) {
+                std::vector<const table*> promotion_tables;
+                if (new_table->has_pawn) {
+                    promotion_tables.push_back(find_table("Q"));
+                    promotion_tables.push_back(find_table("R"));
+                }
+                new_table->generate(promotion_tables);
+                loaded_tables.push_back(std::move(new_table));
+                if (!file_name.empty()) {
+                    loaded_tables.back()->save(file_name);
+                }
+            } else {
+                loaded_tables.push_back(std::move(new_table));
+            }
+        }
+    }
+
+
+    bool are_tablebases_loaded() {
+        return !loaded_tables.empty();
+    }
+
+
+    int get_number_of_pieces(const brd::board& chess_board) {
+        int number_of_pieces{};
+        for (int i{} ; i < 8*8 ; i++) {
+            if (chess_board.get_piece(i)) {
+                number_of_pieces++;
+            }
+        }
+        return number_of_pieces;
+    }
+
+
+    probe_result probe(const brd::board& chess_board, pcs::color side_to_move) {
+        probe_result result{};
+        if (!are_tablebases_loaded()) {
+            return result;
+        }
+
+        int king_squares[2]{-1, -1};
+        std::string piece_symbols[2];
+        std::vector<int> piece_squares[2];
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (!piece) {
+                continue;
+            }
+            if (piece->get_symbol() == 'K') {
+                king_squares[piece->get_piece_color()] = i;
+            } else {
+                piece_symbols[piece->get_piece_color()] += piece->get_symbol();
+                piece_squares[piece->get_piece_color()].push_back(i);
+            }
+            if (piece_symbols[pcs::white].size() + piece_symbols[pcs::black].size() > 2) {
+                return result;
+            }
+        }
+        if (king_squares[pcs::white] < 0 || king_squares[pcs::black] < 0) {
+            return result;
+        }
+
+        // Bare kings are always drawn
+        if (piece_symbols[pcs::white].empty() && piece_symbols[pcs::black].empty()) {
+            result.found = true;
+            result.is_draw = true;
+            return result;
+        }
+        if (!piece_symbols[pcs::white].empty() && !piece_symbols[pcs::black].empty()) {
+            return result;
+        }
+        pcs::color strong_color{piece_symbols[pcs::white].empty() ? pcs::black : pcs::white};
+        table* matching_table{find_table(piece_symbols[strong_color])};
+        if (!matching_table) {
+            return result;
+        }
+
+        // Tables have the strong side playing up the board, so black's pieces are mirrored rank-wise
+        int flip{strong_color == pcs::white ? 0 : 56};
+        table_position position{};
+        position.squares[0] = king_squares[strong_color] ^ flip;
+        position.squares[1] = king_squares[pcs::opposite_color(strong_color)] ^ flip;
+        for (int i{} ; i < static_cast<int>(matching_table->piece_symbols.size()) ; i++) {
+            size_t piece_number{piece_symbols[strong_color].find(matching_table->piece_symbols[i])};
+            position.squares[2 + i] = piece_squares[strong_color][piece_number] ^ flip;
+        }
+        position.strong_to_move = side_to_move == strong_color;
+        if (!matching_table->is_legal(position)) {
+            return result;
+        }
+
+        std::uint8_t value{matching_table->values[matching_table->canonical_index(position)]};
+        if (value == unused_value) {
+            return result;
+        }
+        result.found = true;
+        if (value == draw_value) {
+            result.is_draw = true;
+        } else {
+            result.side_to_move_wins = position.strong_to_move;
+            result.plies_to_mate = value - 1;
+        }
+        return result;
+    }
+}
@@ -0,0 +1,212 @@
+// object-oriented-chess-game/thread_pool.cpp
+//
+// Source file for a work-stealing pool of worker
+// threads shared by the engine and batch jobs
+//
+// Author: Jason Dominguez
+
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <exception>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "thread_pool.hpp"
+
+
+// Class and function definitions
+namespace thr {
+    // Pool and deque of the worker running on this thread, if it is one
+    thread_local thread_pool* current_pool{nullptr};
+    thread_local size_t current_worker_index{};
+
+
+    std::shared_ptr<thread_pool> get_shared_thread_pool() {
+        static std::shared_ptr<thread_pool> shared_pool{std::make_shared<thread_pool>(0)};
+        return shared_pool;
+    }
+
+
+    std::shared_ptr<thread_pool> make_thread_pool(size_t number_of_threads) {
+        if (number_of_threads == 0) {
+            return get_shared_thread_pool();
+        }
+        return std::make_shared<thread_pool>(number_of_threads);
+    }
+}
+
+
+thr::thread_pool::thread_pool(size_t number_of_threads) {
+    thread_pool_options pool_settings{};
+    pool_settings.number_of_threads = number_of_threads;
+    start_workers(pool_settings);
+}
+
+
+thr::thread_pool::thread_pool(const thread_pool_options& pool_settings) {
+    start_workers(pool_settings);
+}
+
+
+thr::thread_pool::~thread_pool() {
+    // Tasks already queued are finished before the workers exit
+    {
+        std::lock_guard<std::mutex> lock{sleep_mutex};
+        is_stopping = true;
+    }
+    task_available.notify_all();
+    for (auto worker_iterator = workers.begin() ; worker_iterator != workers.end() ; worker_iterator++) {
+        worker_iterator->join();
+    }
+}
+
+
+void thr::thread_pool::start_workers(const thread_pool_options& pool_settings) {
+    size_t number_of_cores{std::max(1u, std::thread::hardware_concurrency())};
+    size_t number_of_threads{pool_settings.number_of_threads == 0 ? number_of_cores : pool_settings.number_of_threads};
+    // Every deque exists before any worker can try to steal from it
+    for (size_t i{} ; i < number_of_threads ; i++) {
+        queues.push_back(std::unique_ptr<worker_queue>(new worker_queue));
+    }
+    for (size_t i{} ; i < number_of_threads ; i++) {
+        workers.push_back(std::thread(&thread_pool::run_worker, this, i));
+#ifdef __linux__
+        if (pool_settings.pin_to_cores) {
+            cpu_set_t core_set;
+            CPU_ZERO(&core_set);
+            CPU_SET((pool_settings.first_core + i)%number_of_cores, &core_set);
+            pthread_setaffinity_np(workers.back().native_handle(), sizeof(core_set), &core_set);
+        }
+#endif
+    }
+}
+
+
+void thr::thread_pool::run_worker(size_t worker_index) {
+    current_pool = this;
+    current_worker_index = worker_index;
+    while (true) {
+        if (run_queued_task(worker_index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{sleep_mutex};
+        task_available.wait(lock, [this]() { return is_stopping || queued_tasks > 0; });
+        if (is_stopping && queued_tasks == 0) {
+            return;
+        }
+    }
+}
+
+
+bool thr::thread_pool::run_queued_task(size_t worker_index) {
+    std::function<void()> task;
+    {
+        worker_queue& own_queue{*queues[worker_index]};
+        std::lock_guard<std::mutex> lock{own_queue.queue_mutex};
+        if (!own_queue.tasks.empty()) {
+            task = std::move(own_queue.tasks.back());
+            own_queue.tasks.pop_back();
+        }
+    }
+    // Stealing starts from the next worker along, so thieves spread out over the other deques
+    for (size_t i{1} ; !task && i < queues.size() ; i++) {
+        worker_queue& victim_queue{*queues[(worker_index + i)%queues.size()]};
+        std::lock_guard<std::mutex> lock{victim_queue.queue_mutex};
+        if (!victim_queue.tasks.empty()) {
+            task = std::move(victim_queue.tasks.front());
+            victim_queue.tasks.pop_front();
+            ++tasks_stolen;
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    --queued_tasks;
+    task();
+    return true;
+}
+
+
+void thr::thread_pool::push_task(std::function<void()> task) {
+    // Tasks from outside the pool are dealt out to the workers in turn
+    size_t queue_index{current_pool == this ? current_worker_index : next_queue++%queues.size()};
+    {
+        // Counted before any worker can take the task, so the count never drops below zero
+        std::lock_guard<std::mutex> lock{queues[queue_index]->queue_mutex};
+        ++queued_tasks;
+        queues[queue_index]->tasks.push_back(std::move(task));
+    }
+    // Taking the lock means a worker can't miss the task between checking for one and going to sleep
+    {
+        std::lock_guard<std::mutex> lock{sleep_mutex};
+    }
+    task_available.notify_one();
+}
+
+
+std::future<void> thr::thread_pool::submit(std::function<void()> task) {
+    // Exceptions thrown by the task are passed on through the future
+    std::shared_ptr<std::packaged_task<void()>> packaged_task{std::make_shared<std::packaged_task<void()>>(std::move(task))};
+    std::future<void> result{packaged_task->get_future()};
+    push_task([packaged_task]() { (*packaged_task)(); });
+    return result;
+}
+
+
+void thr::thread_pool::wait(std::future<void>& result) {
+    if (current_pool == this) {
+        while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!run_queued_task(current_worker_index)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    result.get();
+}
+
+
+void thr::thread_pool::parallel_for(size_t number_of_items, size_t chunk_size,
+                                    const std::function<void(size_t, size_t)>& work) {
+    // One task per worker, each taking chunks until there are none left, so workers that
+    // finish early pick up more of the work
+    chunk_size = std::max<size_t>(1, chunk_size);
+    size_t number_of_tasks{std::min(get_number_of_threads(), (number_of_items + chunk_size - 1)/chunk_size)};
+    std::atomic<size_t> next_item{0};
+    std::vector<std::future<void>> tasks;
+    for (size_t i{} ; i < number_of_tasks ; i++) {
+        tasks.push_back(submit([&]() {
+            while (true) {
+                size_t begin{next_item.fetch_add(chunk_size)};
+                if (begin >= number_of_items) {
+                    break;
+                }
+                work(begin, std::min(begin + chunk_size, number_of_items));
+            }
+        }));
+    }
+    // Every task has to finish before returning, even after one fails, as they all use this frame
+    std::exception_ptr first_exception{};
+    for (auto task_iterator = tasks.begin() ; task_iterator != tasks.end() ; task_iterator++) {
+        try {
+            wait(*task_iterator);
+        } catch (...) {
+            if (!first_exception) {
+                first_exception = std::current_exception();
+            }
+        }
+    }
+    if (first_exception) {
+        std::rethrow_exception(first_exception);
+    }
+}
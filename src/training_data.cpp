@@ -0,0 +1,242 @@
+// object-oriented-chess-game/training_data.cpp
+//
+// Source file for the compact binary file of labelled
+// positions used to tune and train the evaluation
+//
+// Author: Jason Dominguez
+
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "evaluation.hpp"
+#include "training_data.hpp"
+
+
+// Class and function definitions
+namespace trn {
+    const char file_magic[8]{'O', 'O', 'C', 'G', 'P', 'O', 'S', '\0'};
+
+    void write_uint32(unsigned char* bytes, std::uint32_t value) {
+        for (int i{} ; i < 4 ; i++) {
+            bytes[i] = static_cast<unsigned char>(value >> (8*i));
+        }
+    }
+
+
+    std::uint32_t read_uint32(const unsigned char* bytes) {
+        std::uint32_t value{};
+        for (int i{} ; i < 4 ; i++) {
+            value |= static_cast<std::uint32_t>(bytes[i]) << (8*i);
+        }
+        return value;
+    }
+
+
+    position_record make_record(const brd::board& chess_board, pcs::color side_to_move, int result, int score) {
+        position_record record{};
+        for (int i{} ; i < 8*8 ; i++) {
+            pcs::chess_piece* piece{chess_board.get_piece(i)};
+            if (!piece) {
+                continue;
+            }
+            std::uint8_t piece_code{static_cast<std::uint8_t>(evl::piece_type(piece->get_symbol()) + 1 +
+                                                              (piece->get_piece_color() == pcs::black ? 8 : 0))};
+            record.squares[i/2] |= i%2 == 0 ? piece_code : piece_code << 4;
+        }
+        record.side_to_move = side_to_move == pcs::white ? 0 : 1;
+        record.result = static_cast<std::uint8_t>(result);
+        record.score = static_cast<std::int16_t>(std::max(-32767, std::min(32767, score)));
+        return record;
+    }
+
+
+    std::string record_to_fen(const position_record& record) {
+        const char fen_symbols[16]{' ', 'P', 'N', 'B', 'R', 'Q', 'K', ' ', ' ', 'p', 'n', 'b', 'r', 'q', 'k', ' '};
+        std::string fen{};
+        for (int row{7} ; row >= 0 ; row--) {
+            int empty_squares{};
+            for (int col{} ; col < 8 ; col++) {
+                int position{row*8 + col};
+                int piece_code{position%2 == 0 ? record.squares[position/2] & 0xf : record.squares[position/2] >> 4};
+                if (fen_symbols[piece_code] == ' ') {
+                    empty_squares++;
+                    continue;
+                }
+                if (empty_squares > 0) {
+                    fen += std::to_string(empty_squares);
+                    empty_squares = 0;
+                }
+                fen += fen_symbols[piece_code];
+            }
+            if (empty_squares > 0) {
+                fen += std::to_string(empty_squares);
+            }
+            if (row > 0) {
+                fen += '/';
+            }
+        }
+        fen += record.side_to_move == 0 ? " w - -" : " b - -";
+        return fen;
+    }
+
+
+    double result_for_white(const position_record& record) {
+        return record.result/2.0;
+    }
+
+
+    long long pack_labelled_positions(std::string text_file_name, std::string data_file_name) {
+        // Each line is a FEN (the first four fields are used) followed anywhere by the game result,
+        // either as 1-0, 0-1 and 1/2-1/2 or as [1.0], [0.5] and [0.0]. Lines without one are skipped
+        std::ifstream text_file{text_file_name};
+        if (!text_file) {
+            throw std::ios_base::failure("Labelled positions file could not be opened");
+        }
+        training_data_writer writer{data_file_name};
+        const std::string result_markers[6]{"1/2-1/2", "1-0", "0-1", "[0.5]", "[1.0]", "[0.0]"};
+        const int marker_results[6]{1, 2, 0, 1, 2, 0};
+        std::string line;
+        while (std::getline(text_file, line)) {
+            int result{-1};
+            for (int i{} ; i < 6 && result < 0 ; i++) {
+                if (line.find(result_markers[i]) != std::string::npos) {
+                    result = marker_results[i];
+                }
+            }
+            if (result < 0) {
+                continue;
+            }
+            try {
+                std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> position{brd::read_fen(line)};
+                brd::board chess_board{position.first};
+                writer.write(make_record(chess_board, position.second, result, 0));
+            } catch (const std::exception& e) {
+                continue;
+            }
+        }
+        writer.close();
+        return writer.get_records_written();
+    }
+
+
+    std::vector<position_record> read_training_data(std::string file_name) {
+        std::ifstream data_file{file_name, std::ios::binary};
+        if (!data_file) {
+            throw std::ios_base::failure("Training data file could not be opened");
+        }
+        unsigned char header[header_size]{};
+        data_file.read(reinterpret_cast<char*>(header), header_size);
+        if (!data_file || std::memcmp(header, file_magic, sizeof(file_magic)) != 0) {
+            throw std::ios_base::failure("Training data file is not valid");
+        }
+        if (read_uint32(header + 8) != training_data_version || read_uint32(header + 12) != record_size) {
+            throw std::ios_base::failure("Training data file has an unsupported format version");
+        }
+
+        // Records are read in large blocks, files often hold millions of them
+        std::vector<position_record> records;
+        const int records_per_block{1 << 14};
+        std::vector<unsigned char> block(records_per_block*record_size);
+        while (data_file) {
+            data_file.read(reinterpret_cast<char*>(block.data()), block.size());
+            std::streamsize bytes_read{data_file.gcount()};
+            if (bytes_read%record_size != 0) {
+                throw std::ios_base::failure("Training data file ends part way through a record");
+            }
+            for (std::streamsize offset{} ; offset < bytes_read ; offset += record_size) {
+                const unsigned char* bytes{block.data() + offset};
+                position_record record{};
+                std::memcpy(record.squares, bytes, 32);
+                record.side_to_move = bytes[32];
+                record.result = bytes[33];
+                record.score = static_cast<std::int16_t>(bytes[34] | (bytes[35] << 8));
+                if (record.side_to_move > 1 || record.result > 2) {
+                    throw std::ios_base::failure("Training data file has an invalid record");
+                }
+                records.push_back(record);
+            }
+        }
+        return records;
+    }
+}
+
+
+trn::training_data_writer::training_data_writer(std::string file_name) : training_data_writer(file_name, false) {}
+
+
+trn::training_data_writer::training_data_writer(std::string file_name, bool append) {
+    struct stat file_status;
+    if (append && stat(file_name.c_str(), &file_status) == 0 && file_status.st_size > 0) {
+        std::ifstream existing_file{file_name, std::ios::binary};
+        unsigned char header[header_size]{};
+        existing_file.read(reinterpret_cast<char*>(header), header_size);
+        if (!existing_file || std::memcmp(header, file_magic, sizeof(file_magic)) != 0 ||
+            read_uint32(header + 8) != training_data_version || read_uint32(header + 12) != record_size) {
+            throw std::ios_base::failure("Training data file to append to is not valid");
+        }
+        existing_file.close();
+        // A record cut short, e.g. by the last run being killed, would put every later record out of step
+        off_t whole_records_size{header_size + (file_status.st_size - header_size)/record_size*record_size};
+        if (whole_records_size != file_status.st_size && truncate(file_name.c_str(), whole_records_size) != 0) {
+            throw std::ios_base::failure("Training data file could not be repaired");
+        }
+        data_file.open(file_name, std::ios::binary | std::ios::app);
+        if (!data_file) {
+            throw std::ios_base::failure("Training data file could not be opened");
+        }
+        return;
+    }
+
+    data_file.open(file_name, std::ios::binary | std::ios::trunc);
+    if (!data_file) {
+        throw std::ios_base::failure("Training data file could not be created");
+    }
+    unsigned char header[header_size]{};
+    std::memcpy(header, file_magic, sizeof(file_magic));
+    write_uint32(header + 8, training_data_version);
+    write_uint32(header + 12, record_size);
+    data_file.write(reinterpret_cast<const char*>(header), header_size);
+}
+
+
+void trn::training_data_writer::write(const position_record& record) {
+    unsigned char bytes[record_size]{};
+    std::memcpy(bytes, record.squares, 32);
+    bytes[32] = record.side_to_move;
+    bytes[33] = record.result;
+    bytes[34] = static_cast<unsigned char>(record.score & 0xff);
+    bytes[35] = static_cast<unsigned char>((record.score >> 8) & 0xff);
+    data_file.write(reinterpret_cast<const char*>(bytes), record_size);
+    if (!data_file) {
+        throw std::ios_base::failure("Training data could not be written");
+    }
+    ++records_written;
+}
+
+
+void trn::training_data_writer::flush() {
+    data_file.flush();
+    if (!data_file) {
+        throw std::ios_base::failure("Training data could not be written");
+    }
+}
+
+
+void trn::training_data_writer::close() {
+    data_file.close();
+    if (!data_file) {
+        throw std::ios_base::failure("Training data file could not be closed");
+    }
+}
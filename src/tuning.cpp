@@ -0,0 +1,234 @@
+// object-oriented-chess-game/tuning.cpp
+//
+// Source file for tuning the evaluation weights
+// on positions labelled with game results
+//
+// Author: Jason Dominguez
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <future>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "chess_pieces.hpp"
+#include "chess_board.hpp"
+#include "chess_engine.hpp"
+#include "evaluation.hpp"
+#include "training_data.hpp"
+#include "tuning.hpp"
+
+
+// Class and function definitions
+namespace tun {
+    // Expected result for white from an evaluation in centipawns
+    double expected_result(double evaluation, double scaling_constant) {
+        return 1.0/(1.0 + std::pow(10.0, -scaling_constant*evaluation/400.0));
+    }
+}
+
+
+tun::evaluation_tuner::evaluation_tuner(const tuning_options& tuning_settings) :
+    options{tuning_settings}, worker_pool{thr::make_thread_pool(std::max(0, tuning_settings.number_of_threads))} {}
+
+
+size_t tun::evaluation_tuner::get_number_of_chunks() const {
+    // A few chunks per thread evens out the work when some threads start late
+    return 4*worker_pool->get_number_of_threads();
+}
+
+
+size_t tun::evaluation_tuner::load_positions(std::string file_name) {
+    std::vector<trn::position_record> records{trn::read_training_data(file_name)};
+
+    // Each chunk turns its records into features on its own thread, then the chunks are joined in order
+    struct chunk_features
+    {
+        std::vector<feature_term> terms;
+        std::vector<std::uint32_t> term_counts;
+        std::vector<std::uint8_t> game_phases;
+        std::vector<float> results;
+    };
+    size_t number_of_chunks{get_number_of_chunks()};
+    size_t chunk_size{(records.size() + number_of_chunks - 1)/number_of_chunks};
+    std::vector<chunk_features> chunks(number_of_chunks);
+    std::vector<std::future<void>> tasks;
+    for (size_t chunk{} ; chunk < number_of_chunks ; chunk++) {
+        tasks.push_back(worker_pool->submit([this, &records, &chunks, chunk, chunk_size]() {
+            eng::search_options search_settings{};
+            search_settings.use_neural_network = false;
+            eng::search quiet_search{search_settings};
+            size_t first_record{std::min(records.size(), chunk*chunk_size)};
+            size_t last_record{std::min(records.size(), first_record + chunk_size)};
+            for (size_t i{first_record} ; i < last_record ; i++) {
+                std::pair<std::vector<std::unique_ptr<pcs::chess_piece>>, pcs::color> position{
+                    brd::read_fen(trn::record_to_fen(records[i]))};
+                brd::board chess_board{position.first};
+                pcs::color side_to_move{position.second};
+                if (options.quiet_positions_only &&
+                    (eng::is_in_check(chess_board, side_to_move) ||
+                     quiet_search.quiet_evaluation(chess_board, side_to_move) != eng::evaluate(chess_board, side_to_move))) {
+                    continue;
+                }
+
+                evl::evaluation_features features{evl::get_evaluation_features(chess_board)};
+                for (int stage{} ; stage < 2 ; stage++) {
+                    for (auto term_iterator = features.terms[stage].begin() ; term_iterator != features.terms[stage].end() ;
+                         term_iterator++) {
+                        chunks[chunk].terms.push_back(feature_term{static_cast<std::uint16_t>(term_iterator->first),
+                                                                   static_cast<std::int16_t>(term_iterator->second)});
+                    }
+                    chunks[chunk].term_counts.push_back(features.terms[stage].size());
+                }
+                chunks[chunk].game_phases.push_back(static_cast<std::uint8_t>(features.game_phase));
+                chunks[chunk].results.push_back(static_cast<float>(trn::result_for_white(records[i])));
+            }
+        }));
+    }
+    for (auto task_iterator = tasks.begin() ; task_iterator != tasks.end() ; task_iterator++) {
+        worker_pool->wait(*task_iterator);
+    }
+
+    for (auto chunk_iterator = chunks.begin() ; chunk_iterator != chunks.end() ; chunk_iterator++) {
+        terms.insert(terms.end(), chunk_iterator->terms.begin(), chunk_iterator->terms.end());
+        for (auto count_iterator = chunk_iterator->term_counts.begin() ; count_iterator != chunk_iterator->term_counts.end() ;
+             count_iterator++) {
+            term_offsets.push_back(term_offsets.back() + *count_iterator);
+        }
+        game_phases.insert(game_phases.end(), chunk_iterator->game_phases.begin(), chunk_iterator->game_phases.end());
+        results.insert(results.end(), chunk_iterator->results.begin(), chunk_iterator->results.end());
+    }
+    return results.size();
+}
+
+
+double tun::evaluation_tuner::compute_error(const std::vector<double>& parameters, std::vector<double>* gradient) {
+    // Mean squared error between results and expected results, and optionally its gradient,
+    // with the positions split between the worker threads
+    size_t number_of_positions{results.size()};
+    if (number_of_positions == 0) {
+        throw std::invalid_argument("No positions to tune on");
+    }
+    size_t number_of_chunks{get_number_of_chunks()};
+    size_t chunk_size{(number_of_positions + number_of_chunks - 1)/number_of_chunks};
+    std::vector<double> chunk_errors(number_of_chunks);
+    std::vector<std::vector<double>> chunk_gradients(gradient ? number_of_chunks : 0, std::vector<double>(parameters.size()));
+    const double derivative_scale{std::log(10.0)*scaling_constant/400.0};
+
+    std::vector<std::future<void>> tasks;
+    for (size_t chunk{} ; chunk < number_of_chunks ; chunk++) {
+        tasks.push_back(worker_pool->submit([&, chunk]() {
+            size_t first_position{std::min(number_of_positions, chunk*chunk_size)};
+            size_t last_position{std::min(number_of_positions, first_position + chunk_size)};
+            double error{};
+            for (size_t i{first_position} ; i < last_position ; i++) {
+                double stage_scores[2]{};
+                for (int stage{} ; stage < 2 ; stage++) {
+                    for (std::uint32_t t{term_offsets[2*i + stage]} ; t < term_offsets[2*i + stage + 1] ; t++) {
+                        stage_scores[stage] += parameters[terms[t].parameter]*terms[t].count;
+                    }
+                }
+                double middlegame_weight{game_phases[i]/static_cast<double>(evl::max_game_phase)};
+                double evaluation{stage_scores[0]*middlegame_weight + stage_scores[1]*(1.0 - middlegame_weight)};
+                double expected{expected_result(evaluation, scaling_constant)};
+                double difference{results[i] - expected};
+                error += difference*difference;
+
+                if (gradient) {
+                    double error_slope{-2.0*difference*expected*(1.0 - expected)*derivative_scale};
+                    std::vector<double>& chunk_gradient{chunk_gradients[chunk]};
+                    for (int stage{} ; stage < 2 ; stage++) {
+                        double stage_slope{error_slope*(stage == 0 ? middlegame_weight : 1.0 - middlegame_weight)};
+                        for (std::uint32_t t{term_offsets[2*i + stage]} ; t < term_offsets[2*i + stage + 1] ; t++) {
+                            chunk_gradient[terms[t].parameter] += stage_slope*terms[t].count;
+                        }
+                    }
+                }
+            }
+            chunk_errors[chunk] = error;
+        }));
+    }
+    for (auto task_iterator = tasks.begin() ; task_iterator != tasks.end() ; task_iterator++) {
+        worker_pool->wait(*task_iterator);
+    }
+
+    double total_error{};
+    for (size_t chunk{} ; chunk < number_of_chunks ; chunk++) {
+        total_error += chunk_errors[chunk];
+    }
+    if (gradient) {
+        gradient->assign(parameters.size(), 0.0);
+        for (size_t chunk{} ; chunk < number_of_chunks ; chunk++) {
+            for (size_t j{} ; j < parameters.size() ; j++) {
+                (*gradient)[j] += chunk_gradients[chunk][j]/number_of_positions;
+            }
+        }
+    }
+    return total_error/number_of_positions;
+}
+
+
+double tun::evaluation_tuner::fit_scaling_constant(const evl::evaluation_weights& weights) {
+    // Golden section search for the sigmoid scale that best fits the current weights, so tuning
+    // only has to improve the evaluation rather than also rescale it
+    std::vector<int> integer_parameters{evl::weights_to_parameters(weights)};
+    std::vector<double> parameters(integer_parameters.begin(), integer_parameters.end());
+    const double golden_ratio{(std::sqrt(5.0) - 1.0)/2.0};
+    double lower{0.05}, upper{4.0};
+    for (int iteration{} ; iteration < 40 ; iteration++) {
+        double first{upper - golden_ratio*(upper - lower)};
+        double second{lower + golden_ratio*(upper - lower)};
+        scaling_constant = first;
+        double first_error{compute_error(parameters, nullptr)};
+        scaling_constant = second;
+        double second_error{compute_error(parameters, nullptr)};
+        if (first_error < second_error) {
+            upper = second;
+        } else {
+            lower = first;
+        }
+    }
+    scaling_constant = (lower + upper)/2.0;
+    return scaling_constant;
+}
+
+
+evl::evaluation_weights tun::evaluation_tuner::tune(const evl::evaluation_weights& initial_weights) {
+    std::vector<int> integer_parameters{evl::weights_to_parameters(initial_weights)};
+    std::vector<double> parameters(integer_parameters.begin(), integer_parameters.end());
+    fit_scaling_constant(initial_weights);
+    std::cout << "Tuning " << parameters.size() << " weights on " << results.size() << " positions (scaling constant "
+              << scaling_constant << ", starting error " << compute_error(parameters, nullptr) << ")" << std::endl;
+
+    // Adam: each weight moves by about the learning rate per epoch in the direction its gradient
+    // has been pointing, however large or small the gradient itself is
+    const double first_moment_decay{0.9};
+    const double second_moment_decay{0.999};
+    const double epsilon{1e-12};
+    std::vector<double> gradient;
+    std::vector<double> first_moments(parameters.size()), second_moments(parameters.size());
+    for (int epoch{1} ; epoch <= options.epochs ; epoch++) {
+        auto epoch_start = std::chrono::steady_clock::now();
+        double error{compute_error(parameters, &gradient)};
+        for (size_t j{} ; j < parameters.size() ; j++) {
+            first_moments[j] = first_moment_decay*first_moments[j] + (1.0 - first_moment_decay)*gradient[j];
+            second_moments[j] = second_moment_decay*second_moments[j] + (1.0 - second_moment_decay)*gradient[j]*gradient[j];
+            double first_moment_estimate{first_moments[j]/(1.0 - std::pow(first_moment_decay, epoch))};
+            double second_moment_estimate{second_moments[j]/(1.0 - std::pow(second_moment_decay, epoch))};
+            parameters[j] -= options.learning_rate*first_moment_estimate/(std::sqrt(second_moment_estimate) + epsilon);
+        }
+        double epoch_seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_start).count()};
+        std::cout << "Epoch " << epoch << ": error " << error << ", "
+                  << static_cast<long long>(results.size()/std::max(epoch_seconds, 1e-9)) << " positions/s" << std::endl;
+    }
+
+    for (size_t j{} ; j < parameters.size() ; j++) {
+        integer_parameters[j] = static_cast<int>(std::lround(parameters[j]));
+    }
+    return evl::parameters_to_weights(integer_parameters);
+}